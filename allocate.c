@@ -43,6 +43,8 @@
 #include "expression.h"
 #include "linearize.h"
 
+unsigned long allocated_blob_bytes;
+
 void protect_allocations(struct allocator_struct *desc)
 {
 	desc->blobs = NULL;
@@ -52,6 +54,7 @@ void drop_all_allocations(struct allocator_struct *desc)
 {
 	struct allocation_blob *blob = desc->blobs;
 
+	allocated_blob_bytes -= desc->total_bytes;
 	desc->blobs = NULL;
 	desc->allocations = 0;
 	desc->total_bytes = 0;
@@ -64,6 +67,34 @@ void drop_all_allocations(struct allocator_struct *desc)
 	}
 }
 
+static struct allocator_struct *func_scoped_allocators;
+
+/*
+ * Mark an allocator as only holding data for the current function.  All of
+ * its blobs are released in one go by drop_func_scope_allocations() so
+ * anything which has to outlive the function must be copied somewhere else.
+ */
+void func_scope_allocations(struct allocator_struct *desc)
+{
+	if (desc->func_scoped)
+		return;
+	desc->func_scoped = 1;
+	desc->next_func_scoped = func_scoped_allocators;
+	func_scoped_allocators = desc;
+}
+
+unsigned long drop_func_scope_allocations(void)
+{
+	struct allocator_struct *desc;
+	unsigned long freed = 0;
+
+	for (desc = func_scoped_allocators; desc; desc = desc->next_func_scoped) {
+		freed += desc->total_bytes;
+		drop_all_allocations(desc);
+	}
+	return freed;
+}
+
 void free_one_entry(struct allocator_struct *desc, void *entry)
 {
 	void **p = entry;
@@ -106,6 +137,7 @@ void *allocate(struct allocator_struct *desc, unsigned int size)
 		if (size > chunking)
 			die("alloc too big");
 		desc->total_bytes += chunking;
+		allocated_blob_bytes += chunking;
 		newblob->next = blob;
 		blob = newblob;
 		desc->blobs = newblob;
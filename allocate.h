@@ -15,6 +15,9 @@ struct allocator_struct {
 	unsigned int alignment;
 	unsigned int chunking;
 	void *freelist;
+	/* allocators which are dropped at the end of every function */
+	struct allocator_struct *next_func_scoped;
+	int func_scoped;
 	/* statistics */
 	unsigned long allocations, total_bytes, useful_bytes;
 };
@@ -25,8 +28,13 @@ struct allocator_stats {
 	unsigned long total_bytes, useful_bytes;
 };
 
+/* bytes held in blobs by every allocator */
+extern unsigned long allocated_blob_bytes;
+
 extern void protect_allocations(struct allocator_struct *desc);
 extern void drop_all_allocations(struct allocator_struct *desc);
+extern void func_scope_allocations(struct allocator_struct *desc);
+extern unsigned long drop_func_scope_allocations(void);
 extern void *allocate(struct allocator_struct *desc, unsigned int size);
 extern void free_one_entry(struct allocator_struct *desc, void *entry);
 extern void show_allocations(struct allocator_struct *);
@@ -39,7 +47,8 @@ extern void show_allocation_stats(void);
 	extern void show_##x##_alloc(void);	\
 	extern void get_##x##_stats(struct allocator_stats *);		\
 	extern void clear_##x##_alloc(void);	\
-	extern void protect_##x##_alloc(void);
+	extern void protect_##x##_alloc(void);	\
+	extern void func_scope_##x##_alloc(void);
 #define DECLARE_ALLOCATOR(x) __DECLARE_ALLOCATOR(struct x, x)
 
 #define __DO_ALLOCATOR(type, objsize, objalign, objname, x)	\
@@ -70,6 +79,10 @@ extern void show_allocation_stats(void);
 	void protect_##x##_alloc(void)				\
 	{							\
 		protect_allocations(&x##_allocator);		\
+	}							\
+	void func_scope_##x##_alloc(void)			\
+	{							\
+		func_scope_allocations(&x##_allocator);		\
 	}
 
 #define __ALLOCATOR(t, n, x) 					\
@@ -28,6 +28,7 @@
 
 static AvlNode *mkNode(const struct sm_state *sm);
 static void freeNode(AvlNode *node);
+static void unshare(AvlNode **p);
 
 static AvlNode *lookup(const struct stree *avl, AvlNode *node, const struct sm_state *sm);
 
@@ -43,6 +44,7 @@ static bool checkOrder(struct stree *avl);
 static size_t countNode(AvlNode *node);
 
 int unfree_stree;
+unsigned long avl_node_count;
 
 /*
  * Utility macros for converting between
@@ -69,6 +71,7 @@ static struct stree *avl_new(void)
 	avl->count = 0;
 	avl->stree_id = 0;
 	avl->references = 1;
+	avl->line = 0;
 	return avl;
 }
 
@@ -88,6 +91,7 @@ void free_stree(struct stree **avl)
 	unfree_stree--;
 
 	freeNode((*avl)->root);
+	free((*avl)->has_states);
 	free(*avl);
 	*avl = NULL;
 }
@@ -119,15 +123,21 @@ size_t stree_count(const struct stree *avl)
 	return avl->count;
 }
 
+/*
+ * The nodes are shared between strees so this only has to copy the header.
+ * The nodes are copied later, one path at a time, when they are modified.
+ */
 static struct stree *clone_stree_real(struct stree *orig)
 {
 	struct stree *new = avl_new();
-	AvlIter i;
-
-	avl_foreach(i, orig)
-		avl_insert(&new, i.sm);
 
+	memcpy(new->has_states, orig->has_states, num_checks * sizeof(char));
+	new->root = orig->root;
+	if (new->root)
+		new->root->refs++;
+	new->count = orig->count;
 	new->base_stree = orig->base_stree;
+
 	return new;
 }
 
@@ -155,6 +165,13 @@ bool avl_remove(struct stree **avl, const struct sm_state *sm)
 
 	if (!*avl)
 		return false;
+	/* don't copy any nodes if there is nothing to remove */
+	if (!lookup(*avl, (*avl)->root, sm)) {
+		if ((*avl)->count == 0)
+			free_stree(avl);
+		return false;
+	}
+
 	/* it's fairly rare for smatch to call avl_remove */
 	if ((*avl)->references > 1) {
 		(*avl)->references--;
@@ -169,6 +186,7 @@ bool avl_remove(struct stree **avl, const struct sm_state *sm)
 	if (node == NULL) {
 		return false;
 	} else {
+		avl_node_count--;
 		free(node);
 		return true;
 	}
@@ -184,16 +202,48 @@ static AvlNode *mkNode(const struct sm_state *sm)
 	node->lr[0] = NULL;
 	node->lr[1] = NULL;
 	node->balance = 0;
+	node->refs = 1;
+	avl_node_count++;
 	return node;
 }
 
 static void freeNode(AvlNode *node)
 {
-	if (node) {
-		freeNode(node->lr[0]);
-		freeNode(node->lr[1]);
-		free(node);
-	}
+	if (!node)
+		return;
+	if (--node->refs > 0)
+		return;
+	freeNode(node->lr[0]);
+	freeNode(node->lr[1]);
+	avl_node_count--;
+	free(node);
+}
+
+/*
+ * Nodes can be shared between several strees.  Before a node is modified
+ * it has to be copied so that the other strees don't see the change.  The
+ * caller must already own the pointer at *p.
+ */
+static void unshare(AvlNode **p)
+{
+	AvlNode *node = *p;
+	AvlNode *new;
+
+	if (!node || node->refs == 1)
+		return;
+
+	new = malloc(sizeof(*new));
+	assert(new != NULL);
+
+	*new = *node;
+	new->refs = 1;
+	if (new->lr[0])
+		new->lr[0]->refs++;
+	if (new->lr[1])
+		new->lr[1]->refs++;
+	node->refs--;
+	avl_node_count++;
+	*p = new;
 }
 
 static AvlNode *lookup(const struct stree *avl, AvlNode *node, const struct sm_state *sm)
@@ -226,8 +276,12 @@ static bool insert_sm(struct stree *avl, AvlNode **p, const struct sm_state *sm)
 		avl->count++;
 		return true;
 	} else {
-		AvlNode *node = *p;
-		int      cmp  = cmp_tracker(sm, node->sm);
+		AvlNode *node;
+		int      cmp;
+
+		unshare(p);
+		node = *p;
+		cmp  = cmp_tracker(sm, node->sm);
 
 		if (cmp == 0) {
 			node->sm = sm;
@@ -254,8 +308,12 @@ static bool remove_sm(struct stree *avl, AvlNode **p, const struct sm_state *sm,
 	if (p == NULL || *p == NULL) {
 		return false;
 	} else {
-		AvlNode *node = *p;
-		int      cmp  = cmp_tracker(sm, node->sm);
+		AvlNode *node;
+		int      cmp;
+
+		unshare(p);
+		node = *p;
+		cmp  = cmp_tracker(sm, node->sm);
 
 		if (cmp == 0) {
 			*ret = node;
@@ -314,7 +372,10 @@ static bool remove_sm(struct stree *avl, AvlNode **p, const struct sm_state *sm,
  */
 static bool removeExtremum(AvlNode **p, int side, AvlNode **ret)
 {
-	AvlNode *node = *p;
+	AvlNode *node;
+
+	unshare(p);
+	node = *p;
 
 	if (node->lr[side] == NULL) {
 		*ret = node;
@@ -357,10 +418,14 @@ static int sway(AvlNode **p, int sway)
 static void balance(AvlNode **p, int side)
 {
 	AvlNode  *node  = *p,
-	         *child = node->lr[side];
+	         *child;
 	int opposite    = 1 - side;
 	int bal         = bal(side);
 
+	/* After a remove, the rotation can pull in nodes from the other side */
+	unshare(&node->lr[side]);
+	child = node->lr[side];
+
 	if (child->balance != -bal) {
 		/* Left-left (side == 0) or right-right (side == 1) */
 		node->lr[side]      = child->lr[opposite];
@@ -372,7 +437,10 @@ static void balance(AvlNode **p, int side)
 
 	} else {
 		/* Left-right (side == 0) or right-left (side == 1) */
-		AvlNode *grandchild = child->lr[opposite];
+		AvlNode *grandchild;
+
+		unshare(&child->lr[opposite]);
+		grandchild = child->lr[opposite];
 
 		node->lr[side]           = grandchild->lr[opposite];
 		child->lr[opposite]      = grandchild->lr[side];
@@ -501,6 +569,40 @@ void avl_iter_next(AvlIter *iter)
 	iter->sm   = (struct sm_state *) node->sm;
 }
 
+/*
+ * Skip the current node and the rest of its subtree.  Everything on the
+ * near side of the node has already been visited.
+ */
+void avl_iter_skip(AvlIter *iter)
+{
+	AvlNode *node;
+
+	if (iter->node == NULL)
+		return;
+
+	if (iter->stack_index == 0) {
+		iter->sm   = NULL;
+		iter->node = NULL;
+		return;
+	}
+
+	node = iter->stack[--iter->stack_index];
+	iter->node = node;
+	iter->sm   = (struct sm_state *) node->sm;
+}
+
+struct stree *clone_stree_nodes(struct stree *orig)
+{
+	struct stree *new;
+
+	if (!orig)
+		return NULL;
+
+	new = clone_stree_real(orig);
+	new->base_stree = NULL;
+	return new;
+}
+
 struct stree *clone_stree(struct stree *orig)
 {
 	if (!orig)
@@ -41,6 +41,8 @@ struct stree {
 	int line;
 };
 
+extern unsigned long avl_node_count;
+
 void free_stree(struct stree **avl);
 	/* Free an stree tree. */
 
@@ -57,6 +59,9 @@ bool avl_insert(struct stree **avl, const struct sm_state *sm);
 	/*
 	 * O(log n). Insert an sm or replace it if already present.
 	 *
+	 * The nodes are shared between cloned strees so only the nodes on the
+	 * path from the root to the sm are copied.
+	 *
 	 * Return false if the insertion replaced an existing sm.
 	 */
 
@@ -128,6 +133,12 @@ struct AvlIter {
 
 void avl_iter_begin(AvlIter *iter, struct stree *avl, AvlDirection dir);
 void avl_iter_next(AvlIter *iter);
+void avl_iter_skip(AvlIter *iter);
+	/*
+	 * Move past the current node and everything after it in the same
+	 * subtree.  If two iterators are on the same node then the rest of
+	 * that subtree is the same in both strees.
+	 */
 #define avl_traverse(iter, avl, direction)        \
 	for (avl_iter_begin(&(iter), avl, direction); \
 	     (iter).node != NULL;                     \
@@ -141,12 +152,15 @@ struct AvlNode {
 
 	AvlNode    *lr[2];
 	int         balance; /* -1, 0, or 1 */
+	int         refs;    /* number of parents (or stree roots) sharing this node */
 };
 
 AvlNode *avl_lookup_node(const struct stree *avl, const struct sm_state *sm);
 	/* O(log n). Lookup an stree node by sm.  Return NULL if not present. */
 
 struct stree *clone_stree(struct stree *orig);
+struct stree *clone_stree_nodes(struct stree *orig);
+	/* O(1). A new stree (no base_stree or id) which shares orig's nodes. */
 
 void set_stree_id(struct stree **stree, int id);
 int get_stree_id(struct stree *stree);
@@ -83,7 +83,7 @@ static void match_state(const char *fn, struct expression *expr, void *info)
 			continue;
 		if (strcmp(sm->name, state_arg->string->data) != 0)
 			continue;
-		sm_msg("'%s' = '%s'", sm->name, sm->state->name);
+		sm_msg("'%s' = '%s'", sm->name, show_state(sm->state));
 		found = 1;
 	} END_FOR_EACH_SM(sm);
 
@@ -125,7 +125,7 @@ static void match_print_value(const char *fn, struct expression *expr, void *inf
 	stree = __get_cur_stree();
 	FOR_EACH_MY_SM(SMATCH_EXTRA, stree, tmp) {
 		if (!strcmp(tmp->name, arg_expr->string->data))
-			sm_msg("%s = %s", tmp->name, tmp->state->name);
+			sm_msg("%s = %s", tmp->name, show_state(tmp->state));
 	} END_FOR_EACH_SM(tmp);
 }
 
@@ -405,7 +405,7 @@ static void print_possible(struct sm_state *sm)
 
 	sm_msg("Possible values for %s", sm->name);
 	FOR_EACH_PTR(sm->possible, tmp) {
-		printf("%s\n", tmp->state->name);
+		printf("%s\n", show_state(tmp->state));
 	} END_FOR_EACH_PTR(tmp);
 	sm_msg("===");
 }
@@ -742,7 +742,7 @@ static void print_left_right(struct sm_state *sm)
 
 	sm_printf("[ ");
 	if (sm->left)
-		sm_printf("(%d: %s->'%s')", get_stree_id(sm->left->pool),  sm->left->name, sm->left->state->name);
+		sm_printf("(%d: %s->'%s')", get_stree_id(sm->left->pool),  sm->left->name, show_state(sm->left->state));
 	else
 		sm_printf(" - ");
 
@@ -750,7 +750,7 @@ static void print_left_right(struct sm_state *sm)
 	print_left_right(sm->left);
 
 	if (sm->right)
-		sm_printf("(%d: %s->'%s')", get_stree_id(sm->right->pool),  sm->right->name, sm->right->state->name);
+		sm_printf("(%d: %s->'%s')", get_stree_id(sm->right->pool),  sm->right->name, show_state(sm->right->state));
 	else
 		sm_printf(" - ");
 
@@ -773,7 +773,7 @@ static void match_print_merge_tree(const char *fn, struct expression *expr, void
 	}
 
 	sm_prefix();
-	sm_printf("merge tree: %s -> %s", name, sm->state->name);
+	sm_printf("merge tree: %s -> %s", name, show_state(sm->state));
 	print_left_right(sm);
 	sm_printf("\n");
 
@@ -999,7 +999,7 @@ static void trace_var(struct statement *stmt)
 			continue;
 		sm_msg("[%d] %s '%s': '%s' => '%s'", stmt->type,
 		       check_name(sm->owner),
-		       sm->name, old ? old->state->name : "<none>", sm->state->name);
+		       sm->name, old ? show_state(old->state) : "<none>", show_state(sm->state));
 		printed = 1;
 	} END_FOR_EACH_SM(sm);
 
@@ -108,7 +108,7 @@ static void check_dereference(struct expression *expr)
 		if (tmp->state == &uninitialized)
 			return;
 		sm_error("potential null dereference '%s'.  (%s returns null)",
-			tmp->name, tmp->state->name);
+			tmp->name, show_state(tmp->state));
 		return;
 	} END_FOR_EACH_PTR(tmp);
 }
@@ -139,7 +139,7 @@ static void check_dereference_name_sym(char *name, struct symbol *sym)
 		if (tmp->state == &uninitialized)
 			return;
 		sm_error("potential null dereference '%s'.  (%s returns null)",
-			tmp->name, tmp->state->name);
+			tmp->name, show_state(tmp->state));
 		return;
 	} END_FOR_EACH_PTR(tmp);
 }
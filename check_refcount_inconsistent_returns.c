@@ -70,7 +70,7 @@ static void check_count(const char *name, struct symbol *sym)
 		sm = get_sm_state(my_id, name, sym);
 
 		if (success_fail_return(estate_rl(return_sm->state)) == RET_SUCCESS) {
-			if (sm && strcmp(sm->state->name, "inc") == 0)
+			if (sm && strcmp(show_state(sm->state), "inc") == 0)
 				success_path_increments++;
 			else
 				success_path_unknown++;
@@ -152,7 +152,7 @@ const char *get_syscall_arg_type(struct symbol *sym)
 	state = get_state(my_id, sym->ident->name, sym);
 	if (!state)
 		return "ARG_UNDEFINED";
-	return state->name;
+	return show_state(state);
 }
 
 void check_syscall_arg_type(int id)
@@ -57,7 +57,7 @@ static void check_add_sub(struct expression *expr)
 	if (!left || !right || left == right)
 		return;
 	str = expr_to_str(expr);
-	sm_warning("missing conversion: '%s' '%s %s %s'", str, left->name, show_special(expr->op), right->name);
+	sm_warning("missing conversion: '%s' '%s %s %s'", str, show_state(left), show_special(expr->op), show_state(right));
 	free_string(str);
 }
 
@@ -91,7 +91,7 @@ static void match_condition_check(struct expression *expr)
 		return;
 
 	str = expr_to_str(expr);
-	sm_msg("warn: comparing different units: '%s' '%s %s %s'", str, left->name, show_special(expr->op), right->name);
+	sm_msg("warn: comparing different units: '%s' '%s %s %s'", str, show_state(left), show_special(expr->op), show_state(right));
 	free_string(str);
 }
 
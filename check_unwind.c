@@ -319,11 +319,11 @@ static const char *get_alloc_fn(struct sm_state *sm)
 		return NULL;
 
 	if (sm->state->data == &alloc)
-		return sm->state->name;
+		return show_state(sm->state);
 
 	FOR_EACH_PTR(sm->possible, tmp) {
 		if (tmp->state->data == &alloc)
-			return tmp->state->name;
+			return show_state(tmp->state);
 	} END_FOR_EACH_PTR(tmp);
 
 	return NULL;
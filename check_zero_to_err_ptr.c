@@ -246,7 +246,7 @@ static void match_err_ptr(const char *fn, struct expression *expr, void *data)
 		if (has_distinct_positive(estate_rl(tmp->state))) {
 			if (is_printing_percent_p(expr))
 				return;
-			sm_warning("passing positive error code '%s' to '%s'", tmp->state->name, fn);
+			sm_warning("passing positive error code '%s' to '%s'", show_state(tmp->state), fn);
 			return;
 		}
 
@@ -49,6 +49,7 @@
 #include "bits.h"
 
 int parse_error;
+unsigned int nr_diagnostics;
 
 static int prettify(const char **fnamep)
 {
@@ -161,6 +162,7 @@ static void do_error(struct position pos, const char * fmt, va_list args)
 {
 	static int errors = 0;
 
+	nr_diagnostics++;
 	parse_error = 1;
         die_if_error = 1;
 	show_info = 1;
@@ -186,6 +188,7 @@ void warning(struct position pos, const char * fmt, ...)
 {
 	va_list args;
 
+	nr_diagnostics++;
 	if (Wsparse_error) {
 		va_start(args, fmt);
 		do_error(pos, fmt, args);
@@ -383,21 +386,8 @@ static struct symbol_list *sparse_initial(void)
 	return sparse_tokenstream(pre_buffer_begin);
 }
 
-struct symbol_list *sparse_initialize(int argc, char **argv, struct string_list **filelist)
+static void handle_args(char **args, struct string_list **filelist)
 {
-	char **args;
-	struct symbol_list *list;
-
-	base_filename = "command-line";
-
-	// Initialize symbol stream first, so that we can add defines etc
-	init_symbols();
-	init_include_path();
-
-	// initialize the default target to the native 'machine'
-	target_config(MACH_NATIVE);
-
-	args = argv;
 	for (;;) {
 		char *arg = *++args;
 		if (!arg)
@@ -410,6 +400,26 @@ struct symbol_list *sparse_initialize(int argc, char **argv, struct string_list
 		add_ptr_list(filelist, arg);
 	}
 	handle_switch_finalize();
+}
+
+/*
+ * sparse_initialize() is split in two for smatch's fork server: the first
+ * half sets up the target and the type system and the second half, which
+ * may be given more arguments, creates the builtin macros and symbols.
+ * The target options must all be passed to the first half.
+ */
+void sparse_early_initialize(int argc, char **argv, struct string_list **filelist)
+{
+	base_filename = "command-line";
+
+	// Initialize symbol stream first, so that we can add defines etc
+	init_symbols();
+	init_include_path();
+
+	// initialize the default target to the native 'machine'
+	target_config(MACH_NATIVE);
+
+	handle_args(argv, filelist);
 
 	// Redirect stdout if needed
 	if (dump_macro_defs || preprocess_only)
@@ -422,12 +432,25 @@ struct symbol_list *sparse_initialize(int argc, char **argv, struct string_list
 	if (fdump_ir == 0)
 		fdump_ir = PASS_FINAL;
 
-	list = NULL;
 	if (filelist) {
 		// Initialize type system
 		target_init();
 		init_ctype();
+	}
+
+	// The pre-buffer tokens have to survive until the late half
+	protect_token_alloc();
+}
 
+struct symbol_list *sparse_late_initialize(int argc, char **argv, struct string_list **filelist)
+{
+	struct symbol_list *list;
+
+	if (argc > 1)
+		handle_args(argv, filelist);
+
+	list = NULL;
+	if (filelist) {
 		predefined_macros();
 		create_builtin_stream();
 		init_builtins(0);
@@ -457,6 +480,12 @@ struct symbol_list *sparse_initialize(int argc, char **argv, struct string_list
 	return list;
 }
 
+struct symbol_list *sparse_initialize(int argc, char **argv, struct string_list **filelist)
+{
+	sparse_early_initialize(argc, argv, filelist);
+	return sparse_late_initialize(0, NULL, filelist);
+}
+
 struct symbol_list * sparse_keep_tokens(char *filename)
 {
 	struct symbol_list *res;
@@ -45,6 +45,7 @@
 #endif
 
 extern int parse_error;
+extern unsigned int nr_diagnostics;
 
 #ifndef PATH_MAX
 #define PATH_MAX 4096			// Hurd doesn't define this
@@ -138,6 +139,8 @@ extern void predefined_macros(void);
 
 extern void dump_macro_definitions(void);
 extern struct symbol_list *sparse_initialize(int argc, char **argv, struct string_list **files);
+extern void sparse_early_initialize(int argc, char **argv, struct string_list **files);
+extern struct symbol_list *sparse_late_initialize(int argc, char **argv, struct string_list **files);
 extern struct symbol_list *__sparse(char *filename);
 extern struct symbol_list *sparse_keep_tokens(char *filename);
 extern struct symbol_list *sparse(char *filename);
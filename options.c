@@ -74,6 +74,7 @@ int dissect_show_all_symbols = 0;
 
 unsigned long fdump_ir;
 int fhosted = 1;
+int finclude_index = 0;
 unsigned int fmax_errors = 100;
 unsigned int fmax_warnings = 100;
 int fmem_report = 0;
@@ -84,6 +85,7 @@ int fpie = 0;
 int fshort_wchar = 0;
 int funsigned_bitfields = 0;
 int funsigned_char = 0;
+const char *ftoken_cache = NULL;
 
 int Waddress = 0;
 int Waddress_space = 1;
@@ -514,11 +516,20 @@ static int handle_fmax_warnings(const char *arg, const char *opt, const struct f
 	return 1;
 }
 
+static int handle_ftoken_cache(const char *arg, const char *opt, const struct flag *flag, int options)
+{
+	if (*opt == '\0')
+		die("error: missing argument to \"%s\"", arg);
+	ftoken_cache = opt;
+	return 1;
+}
+
 static struct flag fflags[] = {
 	{ "diagnostic-prefix",	NULL,	handle_fdiagnostic_prefix },
 	{ "dump-ir",		NULL,	handle_fdump_ir },
 	{ "freestanding",	&fhosted, NULL, OPT_INVERSE },
 	{ "hosted",		&fhosted },
+	{ "include-index",	&finclude_index },
 	{ "linearize",		NULL,	handle_fpasses,	PASS_LINEARIZE },
 	{ "max-errors=",	NULL,	handle_fmax_errors },
 	{ "max-warnings=",	NULL,	handle_fmax_warnings },
@@ -536,6 +547,7 @@ static struct flag fflags[] = {
 	{ "signed-char",	&funsigned_char, NULL,	OPT_INVERSE },
 	{ "short-wchar",	&fshort_wchar },
 	{ "unsigned-char",	&funsigned_char, NULL, },
+	{ "token-cache=",	NULL,	handle_ftoken_cache },
 	{ },
 };
 
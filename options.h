@@ -74,6 +74,7 @@ extern int dissect_show_all_symbols;
 
 extern unsigned long fdump_ir;
 extern int fhosted;
+extern int finclude_index;
 extern unsigned int fmax_errors;
 extern unsigned int fmax_warnings;
 extern int fmem_report;
@@ -84,6 +85,7 @@ extern int fpie;
 extern int fshort_wchar;
 extern int funsigned_bitfields;
 extern int funsigned_char;
+extern const char *ftoken_cache;
 
 extern int Waddress;
 extern int Waddress_space;
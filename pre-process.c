@@ -37,6 +37,7 @@
 #include <time.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/utsname.h>
 
 #include "lib.h"
@@ -1078,6 +1079,310 @@ const char *search_dir(const char *stop, const char *look_for)
 	return NULL;
 }
 
+/*
+ * With -finclude-index the best guess header search uses an index of every
+ * header under the current directory instead of walking the tree for every
+ * missing include.  The index is a text file so that it can be mmapped and
+ * binary searched without parsing it first:
+ *
+ *	F <name> <path>		one line for every .h file, sorted by name
+ *
+ * The fields are separated by tabs.  The tree is often still being built
+ * so the index isn't checked up front.  Instead, the index is rebuilt when
+ * the name isn't in it or when the path it picks is gone.  A process only
+ * does that once and if another process wrote the index in the last few
+ * seconds then it is only reloaded.
+ */
+#define INCLUDE_INDEX ".smatch_include_index"
+#define INCLUDE_INDEX_MAGIC "smatch include index 2\n"
+#define INCLUDE_INDEX_FRESH 10	/* seconds */
+
+static const char *index_map;
+static size_t index_size;
+
+static int is_header_name(const char *name)
+{
+	int len = strlen(name);
+
+	return len > 2 && strcmp(name + len - 2, ".h") == 0;
+}
+
+struct index_walk {
+	FILE *fp;
+	char **files;
+	int nr, max;
+};
+
+static void index_add_file(struct index_walk *walk, const char *name, const char *path)
+{
+	char *line;
+
+	if (walk->nr == walk->max) {
+		walk->max = walk->max ? walk->max * 2 : 1024;
+		walk->files = realloc(walk->files, walk->max * sizeof(char *));
+		if (!walk->files)
+			die("out of memory");
+	}
+	line = malloc(strlen(name) + strlen(path) + 5);
+	if (!line)
+		die("out of memory");
+	sprintf(line, "F\t%s\t%s\n", name, path);
+	walk->files[walk->nr++] = line;
+}
+
+static void index_walk_dir(struct index_walk *walk, const char *dir)
+{
+	char path[PATH_MAX];
+	struct dirent *entry;
+	struct stat statbuf;
+	DIR *dp;
+
+	dp = opendir(dir);
+	if (!dp)
+		return;
+
+	while ((entry = readdir(dp))) {
+		if (strcmp(entry->d_name, ".") == 0 ||
+		    strcmp(entry->d_name, "..") == 0 ||
+		    strcmp(entry->d_name, ".git") == 0 ||
+		    strncmp(entry->d_name, INCLUDE_INDEX, strlen(INCLUDE_INDEX)) == 0 ||
+		    strchr(entry->d_name, '\t') || strchr(entry->d_name, '\n'))
+			continue;
+		if (snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name) >= sizeof(path))
+			continue;
+		if (lstat(path, &statbuf))
+			continue;
+		if (S_ISDIR(statbuf.st_mode))
+			index_walk_dir(walk, path);
+		else if (is_header_name(entry->d_name))
+			index_add_file(walk, entry->d_name, path + 2);
+	}
+	closedir(dp);
+}
+
+static int cmp_index_line(const void *a, const void *b)
+{
+	return strcmp(*(const char **)a, *(const char **)b);
+}
+
+static void build_include_index(void)
+{
+	struct index_walk walk = {};
+	char tmp[64];
+	int i;
+
+	snprintf(tmp, sizeof(tmp), "%s.%d", INCLUDE_INDEX, getpid());
+	walk.fp = fopen(tmp, "w");
+	if (!walk.fp)
+		return;
+
+	fputs(INCLUDE_INDEX_MAGIC, walk.fp);
+	index_walk_dir(&walk, ".");
+	qsort(walk.files, walk.nr, sizeof(char *), cmp_index_line);
+	for (i = 0; i < walk.nr; i++) {
+		fputs(walk.files[i], walk.fp);
+		free(walk.files[i]);
+	}
+	free(walk.files);
+
+	if (fclose(walk.fp) || rename(tmp, INCLUDE_INDEX))
+		unlink(tmp);
+}
+
+static const char *index_next_line(const char *p)
+{
+	const char *end = index_map + index_size;
+
+	p = memchr(p, '\n', end - p);
+	return p ? p + 1 : end;
+}
+
+static void unmap_include_index(void)
+{
+	if (!index_map)
+		return;
+	munmap((void *)index_map, index_size);
+	index_map = NULL;
+}
+
+static int map_include_index(void)
+{
+	struct stat statbuf;
+	int fd;
+
+	fd = open(INCLUDE_INDEX, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	if (fstat(fd, &statbuf) || statbuf.st_size == 0) {
+		close(fd);
+		return 0;
+	}
+	index_size = statbuf.st_size;
+	index_map = mmap(NULL, index_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (index_map == MAP_FAILED) {
+		index_map = NULL;
+		return 0;
+	}
+	if (index_size >= strlen(INCLUDE_INDEX_MAGIC) &&
+	    memcmp(index_map, INCLUDE_INDEX_MAGIC, strlen(INCLUDE_INDEX_MAGIC)) == 0)
+		return 1;
+	unmap_include_index();
+	return 0;
+}
+
+static int load_include_index(void)
+{
+	static int tried;
+
+	if (tried)
+		return !!index_map;
+	tried = 1;
+
+	if (map_include_index())
+		return 1;
+	build_include_index();
+	return map_include_index();
+}
+
+/* Returns 1 if there is a newer index to look at. */
+static int reload_include_index(void)
+{
+	static int reloaded;
+	struct stat statbuf;
+
+	if (reloaded)
+		return 0;
+	reloaded = 1;
+
+	unmap_include_index();
+	if (stat(INCLUDE_INDEX, &statbuf) ||
+	    time(NULL) - statbuf.st_mtime >= INCLUDE_INDEX_FRESH)
+		build_include_index();
+	return map_include_index();
+}
+
+/* Compare the name in an F line against look_for. */
+static int cmp_index_name(const char *line, const char *look_for)
+{
+	const char *name = line + 2;
+	int len = strlen(look_for);
+	int ret;
+
+	ret = strncmp(name, look_for, len);
+	if (ret)
+		return ret;
+	return name[len] == '\t' ? 0 : 1;
+}
+
+/* How many leading directories does path share with dir? */
+static int shared_dirs(const char *dir, const char *path, int *depth)
+{
+	int shared = 0, i = 0;
+
+	*depth = 0;
+	for (; path[i]; i++) {
+		if (path[i] != '/')
+			continue;
+		(*depth)++;
+		if (shared + 1 == *depth && strncmp(dir, path, i) == 0 &&
+		    (dir[i] == '/' || dir[i] == '\0'))
+			shared++;
+	}
+	return shared;
+}
+
+/*
+ * find_include() searches the directory of the file which has the include
+ * first, then its parent and so on up to the current directory.  Pick the
+ * file which is closest to the directory in the same way.  The path is
+ * saved in buf, relative to the current directory.  Returns 0 if there is
+ * no such file in the index.
+ */
+static int search_include_index(const char *dir, const char *look_for, char *buf, int size)
+{
+	const char *lo, *hi, *mid, *p, *best = NULL;
+	int best_shared = -1, best_depth = 0;
+	int best_len = 0;
+	int shared, depth, len;
+
+	/* Find the first line for look_for. */
+	lo = index_map + strlen(INCLUDE_INDEX_MAGIC);
+	hi = index_map + index_size;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		while (mid > lo && mid[-1] != '\n')
+			mid--;
+		if (cmp_index_name(mid, look_for) < 0)
+			lo = index_next_line(mid);
+		else
+			hi = mid;
+	}
+
+	for (p = lo; p < index_map + index_size; p = index_next_line(p)) {
+		const char *path;
+
+		if (cmp_index_name(p, look_for) != 0)
+			break;
+		path = p + 2 + strlen(look_for) + 1;
+		len = index_next_line(p) - path - 1;
+		snprintf(buf, size, "%.*s", len, path);
+		shared = shared_dirs(dir, buf, &depth);
+		if (shared < best_shared)
+			continue;
+		if (shared == best_shared && depth >= best_depth)
+			continue;
+		best = path;
+		best_len = len;
+		best_shared = shared;
+		best_depth = depth;
+	}
+	if (!best)
+		return 0;
+	snprintf(buf, size, "%.*s", best_len, best);
+	return 1;
+}
+
+/*
+ * Returns -1 if the index can't be used and the tree has to be searched.
+ * The index only has .h files so other names are searched too.
+ */
+static int index_lookup(const char *cwd, const char *dir_part, const char *look_for,
+			const char **include_name)
+{
+	static char buf[PATH_MAX + 1];
+	char path[PATH_MAX];
+	char real[PATH_MAX];
+	const char *dir;
+	int found;
+	int len;
+
+	*include_name = NULL;
+	if (!is_header_name(look_for))
+		return -1;
+	if (!load_include_index())
+		return -1;
+	if (!realpath(dir_part, real))
+		return -1;
+	len = strlen(cwd);
+	if (strncmp(real, cwd, len) != 0 || (real[len] != '/' && real[len] != '\0'))
+		return -1;
+	dir = real[len] ? real + len + 1 : "";
+
+	found = search_include_index(dir, look_for, path, sizeof(path));
+	if ((!found || access(path, F_OK)) && reload_include_index())
+		found = search_include_index(dir, look_for, path, sizeof(path));
+	if (!found)
+		return 0;
+	if (access(path, F_OK))
+		return -1;
+
+	if (snprintf(buf, sizeof(buf), "%s/%s", cwd, path) >= sizeof(buf))
+		return -1;
+	*include_name = buf;
+	return 0;
+}
+
 static void use_best_guess_header_file(struct token *token, const char *filename, struct token **list)
 {
 	char cwd[PATH_MAX];
@@ -1115,9 +1420,12 @@ static void use_best_guess_header_file(struct token *token, const char *filename
 	if (!getcwd(cwd, sizeof(cwd)))
 		return;
 
-	chdir(dir_part);
-	include_name = search_dir(cwd, file_part);
-	chdir(cwd);
+	if (!finclude_index ||
+	    index_lookup(cwd, dir_part, file_part, &include_name) < 0) {
+		chdir(dir_part);
+		include_name = search_dir(cwd, file_part);
+		chdir(cwd);
+	}
 	if (!include_name)
 		return;
 	sparse_error(token->pos, "using '%s'", include_name);
@@ -7,6 +7,7 @@
 #define _GNU_SOURCE
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 
 #include <unistd.h>
 #include <limits.h>
@@ -16,6 +17,7 @@
 #include <getopt.h>
 #include <ctype.h>
 #include <errno.h>
+#include <poll.h>
 #include <sqlite3.h>
 
 #include "dissect.h"
@@ -23,6 +25,9 @@
 #define U_DEF (0x100 << U_SHIFT)
 #define SINDEX_DATABASE_VERSION 1
 
+// Commit after this many records from the workers
+#define SINDEX_BATCH_SIZE 10000
+
 #define message(fmt, ...) semind_error(0, 0, (fmt), ##__VA_ARGS__)
 
 static const char *progname;
@@ -37,6 +42,10 @@ static size_t n_cwd;
 // 'add' command options
 static struct string_list *semind_filelist = NULL;
 static int semind_include_local_syms = 0;
+static int semind_jobs = 1;
+
+// In a worker process the records are written to this pipe
+static int semind_worker_fd = -1;
 
 struct semind_streams {
 	sqlite3_int64 id;
@@ -124,6 +133,7 @@ static void show_help_add(int ret)
 	    "\n"
 	    "Options:\n"
 	    "  --include-local-syms   Include into the index local symbols;\n"
+	    "  -j, --jobs=N           Parse files in N worker processes (default: 1);\n"
 	    "  -v, --verbose          Show information about what is being done;\n"
 	    "  -h, --help             Show this text and exit.\n"
 	    "\n"
@@ -294,19 +304,26 @@ static void parse_cmdline_add(int argc, char **argv)
 {
 	static const struct option long_options[] = {
 		{ "include-local-syms", no_argument, NULL, 1 },
+		{ "jobs", required_argument, NULL, 'j' },
 		{ "verbose", no_argument, NULL, 'v' },
 		{ "help", no_argument, NULL, 'h' },
 		{ NULL }
 	};
+	char *end;
 	int c;
 
 	opterr = 0;
 
-	while ((c = getopt_long(argc, argv, "+vh", long_options, NULL)) != -1) {
+	while ((c = getopt_long(argc, argv, "+vhj:", long_options, NULL)) != -1) {
 		switch (c) {
 			case 1:
 				semind_include_local_syms = 1;
 				break;
+			case 'j':
+				semind_jobs = strtol(optarg, &end, 10);
+				if (*end || semind_jobs < 1)
+					semind_error(1, 0, "invalid number of jobs: %s", optarg);
+				break;
 			case 'v':
 				semind_verbose++;
 				break;
@@ -613,8 +630,100 @@ struct index_record {
 	int col;
 };
 
+/*
+ * The workers don't touch the database.  They send the files and records to
+ * the parent over a pipe and the parent writes them.  A worker uses its
+ * stream number as the file id and the parent maps it to the real one.
+ */
+enum {
+	SINDEX_MSG_FILE,
+	SINDEX_MSG_RECORD,
+};
+
+struct semind_msg {
+	int type;
+	int stream;
+	int kind;
+	unsigned int mode;
+	int line;
+	int col;
+	long long mtime;
+	int len[2];
+};
+
+static char worker_buf[65536];
+static size_t worker_buf_len;
+
+static void worker_flush(void)
+{
+	size_t off = 0;
+	ssize_t n;
+
+	while (off < worker_buf_len) {
+		n = write(semind_worker_fd, worker_buf + off, worker_buf_len - off);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			semind_error(1, errno, "write");
+		}
+		off += n;
+	}
+	worker_buf_len = 0;
+}
+
+static void worker_send(struct semind_msg *msg, const char *str0, const char *str1)
+{
+	size_t len = sizeof(*msg) + msg->len[0] + msg->len[1];
+
+	if (len > sizeof(worker_buf))
+		semind_error(1, 0, "record too long");
+
+	if (worker_buf_len + len > sizeof(worker_buf))
+		worker_flush();
+
+	memcpy(worker_buf + worker_buf_len, msg, sizeof(*msg));
+	worker_buf_len += sizeof(*msg);
+	memcpy(worker_buf + worker_buf_len, str0, msg->len[0]);
+	worker_buf_len += msg->len[0];
+	memcpy(worker_buf + worker_buf_len, str1, msg->len[1]);
+	worker_buf_len += msg->len[1];
+}
+
+static sqlite3_int64 worker_add_file(int stream, const char *filename, sqlite3_int64 mtime)
+{
+	struct semind_msg msg = {
+		.type   = SINDEX_MSG_FILE,
+		.stream = stream,
+		.mtime  = mtime,
+		.len    = { strlen(filename), 0 },
+	};
+
+	worker_send(&msg, filename, NULL);
+	return stream;
+}
+
+static void worker_insert_record(struct index_record *rec)
+{
+	struct semind_msg msg = {
+		.type   = SINDEX_MSG_RECORD,
+		.stream = rec->file,
+		.kind   = rec->kind,
+		.mode   = rec->mode,
+		.line   = rec->line,
+		.col    = rec->col,
+		.len    = { rec->ctx_len, rec->sym_len },
+	};
+
+	worker_send(&msg, rec->context, rec->symbol);
+}
+
 static void insert_record(struct index_record *rec)
 {
+	if (semind_worker_fd != -1) {
+		worker_insert_record(rec);
+		return;
+	}
+
 	sqlite_bind_text(insert_rec_stmt,  "@context", rec->context, rec->ctx_len);
 	sqlite_bind_text(insert_rec_stmt,  "@symbol",  rec->symbol, rec->sym_len);
 	sqlite_bind_int64(insert_rec_stmt, "@kind",    rec->kind);
@@ -626,6 +735,38 @@ static void insert_record(struct index_record *rec)
 	sqlite_reset_stmt(insert_rec_stmt);
 }
 
+static sqlite3_int64 add_file(const char *filename, int len, sqlite3_int64 cur_mtime)
+{
+	sqlite3_int64 id;
+
+	sqlite_bind_text(select_file_stmt, "@name", filename, len);
+
+	if (sqlite_run(select_file_stmt) == SQLITE_ROW) {
+		sqlite3_int64 old_mtime;
+
+		id = sqlite3_column_int64(select_file_stmt, 0);
+		old_mtime = sqlite3_column_int64(select_file_stmt, 1);
+
+		sqlite_reset_stmt(select_file_stmt);
+
+		if (cur_mtime == old_mtime)
+			return id;
+
+		sqlite_bind_text(delete_file_stmt, "@name", filename, len);
+		sqlite_run(delete_file_stmt);
+		sqlite_reset_stmt(delete_file_stmt);
+	}
+
+	sqlite_reset_stmt(select_file_stmt);
+
+	sqlite_bind_text(insert_file_stmt,  "@name",  filename, len);
+	sqlite_bind_int64(insert_file_stmt, "@mtime", cur_mtime);
+	sqlite_run(insert_file_stmt);
+	sqlite_reset_stmt(insert_file_stmt);
+
+	return sqlite3_last_insert_rowid(semind_db);
+}
+
 static void update_stream(void)
 {
 	if (semind_streams_nr >= input_stream_nr)
@@ -635,7 +776,8 @@ static void update_stream(void)
 	if (!semind_streams)
 		semind_error(1, errno, "realloc");
 
-	sqlite_run(lock_stmt);
+	if (semind_worker_fd == -1)
+		sqlite_run(lock_stmt);
 
 	for (int i = semind_streams_nr; i < input_stream_nr; i++) {
 		struct stat st;
@@ -670,35 +812,14 @@ static void update_stream(void)
 		if (semind_verbose > 1)
 			message("filename: %s", filename);
 
-		sqlite_bind_text(select_file_stmt, "@name", filename, -1);
-
-		if (sqlite_run(select_file_stmt) == SQLITE_ROW) {
-			sqlite3_int64 old_mtime;
-
-			semind_streams[i].id = sqlite3_column_int64(select_file_stmt, 0);
-			old_mtime = sqlite3_column_int64(select_file_stmt, 1);
-
-			sqlite_reset_stmt(select_file_stmt);
-
-			if (cur_mtime == old_mtime)
-				continue;
-
-			sqlite_bind_text(delete_file_stmt, "@name", filename, -1);
-			sqlite_run(delete_file_stmt);
-			sqlite_reset_stmt(delete_file_stmt);
-		}
-
-		sqlite_reset_stmt(select_file_stmt);
-
-		sqlite_bind_text(insert_file_stmt,  "@name",  filename, -1);
-		sqlite_bind_int64(insert_file_stmt, "@mtime", cur_mtime);
-		sqlite_run(insert_file_stmt);
-		sqlite_reset_stmt(insert_file_stmt);
-
-		semind_streams[i].id = sqlite3_last_insert_rowid(semind_db);
+		if (semind_worker_fd != -1)
+			semind_streams[i].id = worker_add_file(i, filename, cur_mtime);
+		else
+			semind_streams[i].id = add_file(filename, -1, cur_mtime);
 	}
 
-	sqlite_run(unlock_stmt);
+	if (semind_worker_fd == -1)
+		sqlite_run(unlock_stmt);
 
 	semind_streams_nr = input_stream_nr;
 }
@@ -787,6 +908,244 @@ static void r_memdef(struct symbol *sym, struct symbol *mem)
 	r_member(U_DEF, &mem->pos, sym, mem);
 }
 
+struct semind_worker {
+	pid_t pid;
+	int fd;
+
+	char *buf;
+	size_t len;
+	size_t size;
+
+	// file ids by worker stream number
+	sqlite3_int64 *files;
+	int files_nr;
+};
+
+static struct string_list *worker_filelist(int worker)
+{
+	struct string_list *list = NULL;
+	char *file;
+	int i = 0;
+
+	FOR_EACH_PTR(semind_filelist, file) {
+		if (i++ % semind_jobs == worker)
+			add_ptr_list(&list, file);
+	} END_FOR_EACH_PTR(file);
+
+	return list;
+}
+
+static void start_worker(struct semind_worker *workers, int nr, struct reporter *reporter)
+{
+	int fds[2];
+	pid_t pid;
+
+	if (pipe(fds) < 0)
+		semind_error(1, errno, "pipe");
+
+	fflush(stdout);
+	fflush(stderr);
+
+	if ((pid = fork()) < 0)
+		semind_error(1, errno, "fork");
+
+	if (!pid) {
+		for (int i = 0; i < nr; i++)
+			close(workers[i].fd);
+		close(fds[0]);
+
+		semind_worker_fd = fds[1];
+		dissect(reporter, worker_filelist(nr));
+		worker_flush();
+
+		// The database connection belongs to the parent.
+		_exit(0);
+	}
+
+	close(fds[1]);
+
+	workers[nr].pid = pid;
+	workers[nr].fd = fds[0];
+}
+
+static void worker_set_file(struct semind_worker *w, int stream, sqlite3_int64 id)
+{
+	if (stream >= w->files_nr) {
+		int nr = stream + 64;
+
+		w->files = realloc(w->files, nr * sizeof(*w->files));
+		if (!w->files)
+			semind_error(1, errno, "realloc");
+
+		for (int i = w->files_nr; i < nr; i++)
+			w->files[i] = -1;
+		w->files_nr = nr;
+	}
+	w->files[stream] = id;
+}
+
+static void process_msg(struct semind_worker *w, struct semind_msg *msg, const char *str)
+{
+	struct index_record rec;
+
+	switch (msg->type) {
+		case SINDEX_MSG_FILE:
+			worker_set_file(w, msg->stream, add_file(str, msg->len[0], msg->mtime));
+			break;
+		case SINDEX_MSG_RECORD:
+			if (msg->stream < 0 || msg->stream >= w->files_nr || w->files[msg->stream] == -1)
+				semind_error(1, 0, "worker %d: record for unknown file", w->pid);
+
+			rec.context = str;
+			rec.ctx_len = msg->len[0];
+			rec.symbol  = str + msg->len[0];
+			rec.sym_len = msg->len[1];
+			rec.kind    = msg->kind;
+			rec.mode    = msg->mode;
+			rec.file    = w->files[msg->stream];
+			rec.line    = msg->line;
+			rec.col     = msg->col;
+
+			insert_record(&rec);
+			break;
+		default:
+			semind_error(1, 0, "worker %d: bad message", w->pid);
+	}
+}
+
+/*
+ * Reads what is available from a worker and writes the complete messages.
+ * Returns the number of messages or -1 at the end of the stream.
+ */
+static int read_worker(struct semind_worker *w)
+{
+	struct semind_msg msg;
+	size_t off = 0, len;
+	ssize_t n;
+	int count = 0;
+
+	if (w->size - w->len < sizeof(worker_buf)) {
+		w->size = w->size ? w->size * 2 : 2 * sizeof(worker_buf);
+		w->buf = realloc(w->buf, w->size);
+		if (!w->buf)
+			semind_error(1, errno, "realloc");
+	}
+
+	n = read(w->fd, w->buf + w->len, w->size - w->len);
+	if (n < 0) {
+		if (errno == EINTR || errno == EAGAIN)
+			return 0;
+		semind_error(1, errno, "read");
+	}
+	if (!n) {
+		if (w->len)
+			semind_error(1, 0, "worker %d: truncated message", w->pid);
+		return -1;
+	}
+	w->len += n;
+
+	while (w->len - off >= sizeof(msg)) {
+		memcpy(&msg, w->buf + off, sizeof(msg));
+		len = sizeof(msg) + msg.len[0] + msg.len[1];
+		if (w->len - off < len)
+			break;
+		process_msg(w, &msg, w->buf + off + sizeof(msg));
+		off += len;
+		count++;
+	}
+
+	memmove(w->buf, w->buf + off, w->len - off);
+	w->len -= off;
+
+	return count;
+}
+
+/*
+ * Every worker parses a share of the files in its own process so the sparse
+ * state isn't shared.  This process is the only one which writes to the
+ * database.  It keeps a transaction open while there is data to read and
+ * commits when the workers are busy or after SINDEX_BATCH_SIZE records.
+ */
+static void run_workers(struct reporter *reporter)
+{
+	struct semind_worker *workers;
+	struct pollfd *pfds;
+	int active, in_transaction = 0, batch = 0;
+	int ret, status;
+
+	workers = calloc(semind_jobs, sizeof(*workers));
+	pfds = calloc(semind_jobs, sizeof(*pfds));
+	if (!workers || !pfds)
+		semind_error(1, errno, "calloc");
+
+	for (int i = 0; i < semind_jobs; i++)
+		start_worker(workers, i, reporter);
+
+	for (int i = 0; i < semind_jobs; i++) {
+		pfds[i].fd = workers[i].fd;
+		pfds[i].events = POLLIN;
+	}
+
+	active = semind_jobs;
+	while (active) {
+		ret = poll(pfds, semind_jobs, in_transaction ? 0 : -1);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			semind_error(1, errno, "poll");
+		}
+
+		if (!ret) {
+			sqlite_run(unlock_stmt);
+			in_transaction = 0;
+			continue;
+		}
+
+		if (!in_transaction) {
+			sqlite_run(lock_stmt);
+			in_transaction = 1;
+			batch = 0;
+		}
+
+		for (int i = 0; i < semind_jobs; i++) {
+			if (!pfds[i].revents)
+				continue;
+
+			ret = read_worker(&workers[i]);
+			if (ret < 0) {
+				close(pfds[i].fd);
+				pfds[i].fd = -1;
+				active--;
+				continue;
+			}
+			batch += ret;
+		}
+
+		if (batch >= SINDEX_BATCH_SIZE) {
+			sqlite_run(unlock_stmt);
+			in_transaction = 0;
+		}
+	}
+
+	if (in_transaction)
+		sqlite_run(unlock_stmt);
+
+	for (int i = 0; i < semind_jobs; i++) {
+		while (waitpid(workers[i].pid, &status, 0) < 0) {
+			if (errno != EINTR)
+				semind_error(1, errno, "waitpid");
+		}
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			semind_error(1, 0, "worker %d failed", workers[i].pid);
+
+		free(workers[i].buf);
+		free(workers[i].files);
+	}
+
+	free(workers);
+	free(pfds);
+}
+
 static void command_add(int argc, char **argv)
 {
 	static struct reporter reporter = {
@@ -795,6 +1154,7 @@ static void command_add(int argc, char **argv)
 		.r_memdef = r_memdef,
 		.r_member = r_member,
 	};
+	int nr_files;
 
 	open_temp_database();
 
@@ -824,7 +1184,14 @@ static void command_add(int argc, char **argv)
 		"DELETE FROM file WHERE name == @name",
 		&delete_file_stmt);
 
-	dissect(&reporter, semind_filelist);
+	nr_files = ptr_list_size((struct ptr_list *)semind_filelist);
+	if (semind_jobs > nr_files)
+		semind_jobs = nr_files ?: 1;
+
+	if (semind_jobs > 1)
+		run_workers(&reporter);
+	else
+		dissect(&reporter, semind_filelist);
 
 	sqlite_run(lock_stmt);
 	sqlite_command("INSERT OR IGNORE INTO semind SELECT * FROM tempdb.semind");
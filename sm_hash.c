@@ -22,15 +22,17 @@ unsigned long long str_to_llu_hash_helper(const char *str);
 int main(int argc, char **argv)
 {
 	unsigned long long hash;
+	int i;
 
-	if (argc != 2) {
-		printf("Usage: sm_hash <string>\n");
+	if (argc < 2) {
+		printf("Usage: sm_hash <string>...\n");
 		return -1;
 	}
 
-	hash = str_to_llu_hash_helper(argv[1]);
-
-	printf("%llu\n", hash);
+	for (i = 1; i < argc; i++) {
+		hash = str_to_llu_hash_helper(argv[i]);
+		printf("%llu\n", hash);
+	}
 
 	return 0;
 }
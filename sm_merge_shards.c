@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * Loads the shards written by "smatch --info --info-shard=<dir>" into
+ * smatch_db.sqlite.  This does the same thing as running fill_db_sql.pl on
+ * the "SQL:" and "SQL_late:" lines, but the rows are copied with prepared
+ * inserts and everything is done in one transaction.
+ *
+ * The constraints table has an id which is only unique inside a shard so
+ * only the strings are copied and the main DB picks the ids.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sqlite3.h>
+
+static sqlite3 *db;
+
+static int exec(const char *sql)
+{
+	char *err = NULL;
+
+	if (sqlite3_exec(db, sql, NULL, NULL, &err) == SQLITE_OK)
+		return 0;
+	fprintf(stderr, "sm_merge_shards: %s\nSQL: %s\n", err, sql);
+	sqlite3_free(err);
+	return -1;
+}
+
+static int prepare(sqlite3 *conn, sqlite3_stmt **stmt, const char *sql)
+{
+	if (sqlite3_prepare_v2(conn, sql, -1, stmt, NULL) == SQLITE_OK)
+		return 0;
+	fprintf(stderr, "sm_merge_shards: %s\nSQL: %s\n", sqlite3_errmsg(conn), sql);
+	return -1;
+}
+
+static char *insert_sql(const char *table, int cols)
+{
+	char *values, *sql;
+	int i;
+
+	if (strcmp(table, "late_sql") == 0)
+		return sqlite3_mprintf("insert into temp.late_sql values (?);");
+	if (strcmp(table, "constraints") == 0)
+		return sqlite3_mprintf("insert or ignore into constraints (str) values (?);");
+
+	values = sqlite3_mprintf("?");
+	for (i = 1; i < cols; i++) {
+		char *tmp = sqlite3_mprintf("%s, ?", values);
+
+		sqlite3_free(values);
+		values = tmp;
+	}
+	sql = sqlite3_mprintf("insert or ignore into \"%w\" values (%s);", table, values);
+	sqlite3_free(values);
+	return sql;
+}
+
+static int merge_table(sqlite3 *shard, const char *table)
+{
+	sqlite3_stmt *select, *insert;
+	char *sql;
+	int cols, i, rc;
+	int ret = 0;
+
+	if (strcmp(table, "constraints") == 0)
+		sql = sqlite3_mprintf("select str from constraints order by id;");
+	else
+		sql = sqlite3_mprintf("select * from \"%w\";", table);
+	rc = prepare(shard, &select, sql);
+	sqlite3_free(sql);
+	if (rc)
+		return -1;
+
+	cols = sqlite3_column_count(select);
+	sql = insert_sql(table, cols);
+	rc = prepare(db, &insert, sql);
+	sqlite3_free(sql);
+	if (rc) {
+		sqlite3_finalize(select);
+		return -1;
+	}
+
+	while (sqlite3_step(select) == SQLITE_ROW) {
+		for (i = 0; i < cols; i++)
+			sqlite3_bind_value(insert, i + 1, sqlite3_column_value(select, i));
+		rc = sqlite3_step(insert);
+		if (rc != SQLITE_DONE && rc != SQLITE_CONSTRAINT) {
+			fprintf(stderr, "sm_merge_shards: %s: %s\n", table, sqlite3_errmsg(db));
+			ret = -1;
+		}
+		sqlite3_reset(insert);
+	}
+
+	sqlite3_finalize(insert);
+	sqlite3_finalize(select);
+	return ret;
+}
+
+static int merge_shard(const char *filename)
+{
+	sqlite3_stmt *stmt;
+	sqlite3 *shard;
+	int ret = 0;
+
+	if (sqlite3_open_v2(filename, &shard, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+		fprintf(stderr, "sm_merge_shards: cannot open %s\n", filename);
+		sqlite3_close(shard);
+		return -1;
+	}
+
+	if (prepare(shard, &stmt, "select name from sqlite_master where type = 'table';")) {
+		sqlite3_close(shard);
+		return -1;
+	}
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		if (merge_table(shard, (const char *)sqlite3_column_text(stmt, 0)))
+			ret = -1;
+	}
+	sqlite3_finalize(stmt);
+	sqlite3_close(shard);
+
+	return ret;
+}
+
+static void run_late_sql(void)
+{
+	sqlite3_stmt *stmt;
+
+	if (prepare(db, &stmt, "select stmt from temp.late_sql order by rowid;"))
+		return;
+	/* These are allowed to fail, the same as with fill_db_sql.pl. */
+	while (sqlite3_step(stmt) == SQLITE_ROW)
+		exec((const char *)sqlite3_column_text(stmt, 0));
+	sqlite3_finalize(stmt);
+}
+
+int main(int argc, char **argv)
+{
+	int ret = 0;
+	int i;
+
+	if (argc < 3) {
+		printf("Usage: sm_merge_shards <db_file> <shard>...\n");
+		return -1;
+	}
+
+	if (sqlite3_open(argv[1], &db) != SQLITE_OK) {
+		fprintf(stderr, "sm_merge_shards: cannot open %s\n", argv[1]);
+		return -1;
+	}
+
+	if (exec("PRAGMA cache_size = 800000;"
+		 "PRAGMA journal_mode = OFF;"
+		 "PRAGMA synchronous = OFF;"
+		 "PRAGMA temp_store = MEMORY;"
+		 "create temp table late_sql (stmt text);"
+		 "begin transaction;"))
+		return -1;
+
+	for (i = 2; i < argc; i++) {
+		if (merge_shard(argv[i]))
+			ret = -1;
+	}
+	run_late_sql();
+
+	if (exec("commit;"))
+		ret = -1;
+	sqlite3_close(db);
+
+	return ret;
+}
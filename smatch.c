@@ -31,6 +31,7 @@ char *option_process_function;
 char *option_project_str = (char *)"smatch_generic";
 char *option_strip_path = NULL;
 static char *option_db_file = (char *)"smatch_db.sqlite";
+static char *option_info_shard;
 enum project_type option_project = PROJ_NONE;
 char *bin_dir;
 char *data_dir;
@@ -48,6 +49,7 @@ int option_file_output;
 int option_time;
 int option_time_stmt;
 int option_mem;
+int option_db_stats;
 char *option_datadir_str;
 int option_fatal_checks;
 int option_succeed;
@@ -147,15 +149,26 @@ static void help(void)
 	printf("--spammy:  print superfluous crap.\n");
 	printf("--pedantic:  intended for reviewing new drivers.\n");
 	printf("--info:  print info used to fill smatch_data/.\n");
+	printf("--info-shard=<dir>: with --info save the SQL to a SQLite file in <dir>.\n");
 	printf("--debug:  print lots of debug output.\n");
 	printf("--no-data:  do not use the /smatch_data/ directory.\n");
 	printf("--data=<dir>: overwrite path to default smatch data directory.\n");
 	printf("--full-path:  print the full pathname.\n");
 	printf("--debug-implied:  print debug output about implications.\n");
+	printf("--debug-sname:  check interned name ordering against strcmp().\n");
 	printf("--assume-loops:  assume loops always go through at least once.\n");
 	printf("--two-passes:  use a two pass system for each function.\n");
 	printf("--file-output:  instead of printing stdout, print to \"file.c.smatch_out\".\n");
 	printf("--fatal-checks: check output is treated as an error.\n");
+	printf("--json:  print the warnings as JSON lines with a stable fingerprint (not with --info).\n");
+	printf("--mem-budget=<MB>: degrade the analysis as memory use approaches this limit.\n");
+	printf("--work-budget=<units>: turn off implications after this much work in a function.\n");
+	printf("--db-stats:  print how many times each database query was run and how long it took.\n");
+	printf("--profile-checks:  print how much time each check spent in its hooks.\n");
+	printf("--profile-checks-json=<file>: same as --profile-checks and save the table as JSON.\n");
+	printf("--fork-server=<socket>: initialize once and analyze each file sent by --connect in a forked process.\n");
+	printf("--connect=<socket>: send the rest of the arguments to a --fork-server.\n");
+	printf("--function-jobs=<n>: analyze the functions in a file with <n> processes (not with --info).\n");
 	printf("--help:  print this helpful message.\n");
 	exit(1);
 }
@@ -219,11 +232,53 @@ void parse_args(int *argcp, char ***argvp)
 			(*argvp)[1] = (*argvp)[0];
 			found = 1;
 		}
+		if (!found && !strncmp((*argvp)[1], "--info-shard=", 13)) {
+			option_info_shard = (*argvp)[1] + 13;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--profile-checks-json=", 22)) {
+			option_profile_json = (*argvp)[1] + 22;
+			option_profile_checks = 1;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--fork-server=", 14)) {
+			option_fork_server = (*argvp)[1] + 14;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--connect=", 10)) {
+			option_connect = (*argvp)[1] + 10;
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--function-jobs=", 16)) {
+			option_function_jobs = strtoul((*argvp)[1] + 16, NULL, 10);
+			if (!option_function_jobs)
+				sm_fatal("invalid --function-jobs: '%s'", (*argvp)[1] + 16);
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
 		if (!found && !strncmp((*argvp)[1], "--data=", 7)) {
 			option_datadir_str = (*argvp)[1] + 7;
 			(*argvp)[1] = (*argvp)[0];
 			found = 1;
 		}
+		if (!found && !strncmp((*argvp)[1], "--mem-budget=", 13)) {
+			option_mem_budget = strtoul((*argvp)[1] + 13, NULL, 10);
+			if (!option_mem_budget)
+				sm_fatal("invalid --mem-budget: '%s'", (*argvp)[1] + 13);
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
+		if (!found && !strncmp((*argvp)[1], "--work-budget=", 14)) {
+			option_work_budget = strtoul((*argvp)[1] + 14, NULL, 10);
+			if (!option_work_budget)
+				sm_fatal("invalid --work-budget: '%s'", (*argvp)[1] + 14);
+			(*argvp)[1] = (*argvp)[0];
+			found = 1;
+		}
 		if (!found && !strncmp((*argvp)[1], "--debug=", 8)) {
 			option_debug_check = (*argvp)[1] + 8;
 			(*argvp)[1] = (*argvp)[0];
@@ -272,15 +327,23 @@ void parse_args(int *argcp, char ***argvp)
 		OPTION(time);
 		OPTION(time_stmt);
 		OPTION(mem);
+		OPTION(db_stats);
+		OPTION(profile_checks);
+		OPTION(json);
 		OPTION(no_db);
 		OPTION(succeed);
 		OPTION(print_names);
+		OPTION(debug_sname);
 		if (!found)
 			break;
 		(*argcp)--;
 		(*argvp)++;
 	}
 
+	/* fill_db_sql.pl needs the "SQL:" lines as text */
+	if (option_json && option_info)
+		sm_fatal("--json can't be used with --info");
+
 	if (strcmp(option_project_str, "smatch_generic") != 0)
 		option_project = PROJ_UNKNOWN;
 
@@ -378,6 +441,8 @@ void segfaulthandler(int _)
 int main(int argc, char **argv)
 {
 	struct string_list *filelist = NULL;
+	char buf[PATH_MAX];
+	int orig_argc;
 	int i;
 	reg_func func;
 
@@ -387,10 +452,19 @@ int main(int argc, char **argv)
 	sql_outfd = stdout;
 	caller_info_fd = stdout;
 
+	orig_argc = argc;
 	parse_args(&argc, &argv);
 
-	if (argc < 2)
+	if (option_connect) {
+		/* the smatch options come from the --fork-server command line */
+		if (orig_argc - argc != 1)
+			sm_fatal("--connect can't be used with other smatch options");
+		return fork_server_client(option_connect, argc, argv);
+	}
+
+	if (argc < 2 && !option_fork_server)
 		help();
+	sm_json_setup_stream(stdout);
 
 
     signal(SIGSEGV, segfaulthandler);
@@ -405,8 +479,16 @@ int main(int argc, char **argv)
 	allocate_dynamic_states_array(num_checks);
 	allocate_tracker_array(num_checks);
 	create_function_hook_hash();
+	/* the workers reopen the DB after changing to the client's directory */
+	if (option_fork_server && realpath(option_db_file, buf))
+		option_db_file = alloc_string(buf);
 	open_smatch_db(option_db_file);
-	sparse_initialize(argc, argv, &filelist);
+	if (option_fork_server) {
+		sparse_early_initialize(argc, argv, &filelist);
+	} else {
+		open_info_shard(option_info_shard);
+		sparse_initialize(argc, argv, &filelist);
+	}
 	alloc_ptr_constants();
 	SMATCH_EXTRA = id_from_name("register_smatch_extra");
 	allocate_modification_hooks();
@@ -423,6 +505,16 @@ int main(int argc, char **argv)
 	}
 	__cur_check_id = 0;
 
+	if (option_fork_server) {
+		/* this only returns in the worker process */
+		run_fork_server(option_fork_server, &argc, &argv);
+		reopen_smatch_db(option_db_file);
+		open_info_shard(option_info_shard);
+		filelist = NULL;
+		sparse_late_initialize(argc, argv, &filelist);
+	}
+
+	allocate_check_profile();
 	smatch(filelist);
 	free_string(data_dir);
 
@@ -35,9 +35,15 @@
 
 typedef long long mtag_t;
 
+/*
+ * Read the name with show_state().  States which are expensive to print leave
+ * ->name NULL and set ->render instead.  It is called the first time the name
+ * is needed and the string is saved in ->name.
+ */
 struct smatch_state {
 	const char *name;
 	void *data;
+	const char *(*render)(struct smatch_state *state);
 };
 #define STATE(_x) static struct smatch_state _x = { .name = #_x }
 #define GLOBAL_STATE(_x) struct smatch_state _x = { .name = #_x }
@@ -65,6 +71,18 @@ static inline int PTR_INT(void *p)
 	return (int)(long)p;
 }
 
+/*
+ * Mixes @val into @hash for the open addressing tables.  The keys are
+ * mostly pointers so the low bits are zero and the high bits are the same.
+ */
+static inline unsigned int hash_mix(unsigned int hash, unsigned long long val)
+{
+	val ^= hash;
+	val ^= val >> 17;
+	val *= 0x9e3779b97f4a7c15ULL;
+	return val >> 32;
+}
+
 struct tracker {
 	char *name;
 	struct symbol *sym;
@@ -369,6 +387,11 @@ static inline void print_implied_debug_msg();
 
 extern bool __silence_warnings_for_stmt;
 
+/* smatch_json.c */
+extern int option_json;
+void sm_json_msg(int type, const char *check, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+void sm_json_setup_stream(FILE *fp);
+
 #define sm_print_msg(type, msg...) \
 do {                                                           \
 	print_implied_debug_msg();                             \
@@ -378,6 +401,10 @@ do {                                                           \
 		break;					       \
 	if (!option_info && is_silenced_function())	       \
 		break;					       \
+	if (option_json) {				       \
+		sm_json_msg(type, __CHECKNAME__, msg);	       \
+		break;					       \
+	}						       \
 	sm_prefix();					       \
 	if (type == 1) {				       \
 		sm_printf("warn: ");			       \
@@ -569,7 +596,9 @@ int known_condition_false(struct expression *expr);
 int implied_condition_true(struct expression *expr);
 int implied_condition_false(struct expression *expr);
 int can_integer_overflow(struct symbol *type, struct expression *expr);
+extern unsigned long value_cache_hits, value_cache_misses;
 void clear_math_cache(void);
+extern unsigned long expr_str_cache_hits, expr_str_cache_misses;
 void clear_strip_cache(void);
 void set_fast_math_only(void);
 void clear_fast_math_only(void);
@@ -771,7 +800,16 @@ extern struct statement *__cur_stmt;
 extern struct statement *__next_stmt;
 void init_fake_env(void);
 void end_fake_env(void);
-int time_parsing_function(void);
+#define DEFAULT_WORK_BUDGET 60000000
+extern unsigned long option_work_budget;
+extern unsigned long __fn_work;
+extern unsigned long __outer_fn_work;
+static inline void add_work(unsigned long units)
+{
+	__fn_work += units;
+	__outer_fn_work += units;
+}
+unsigned long work_parsing_function(void);
 bool taking_too_long(void);
 struct statement *get_last_stmt(void);
 int is_last_stmt(struct statement *cur_stmt);
@@ -807,6 +845,7 @@ struct stree *__implied_case_stree(struct expression *switch_expr,
 				   struct range_list_stack **remaining_cases,
 				   struct stree **raw_stree);
 void overwrite_states_using_pool(struct sm_state *gate_sm, struct sm_state *pool_sm);
+void invalidate_pool_cache(void);
 int assume(struct expression *expr);
 void end_assume(void);
 int impossible_assumption(struct expression *left, int op, sval_t sval);
@@ -953,6 +992,78 @@ void __call_all_scope_hooks(void);
 void add_array_initialized_hook(void (*hook)(struct expression *array, int nr));
 void __call_array_initialized_hooks(struct expression *array, int nr);
 
+/* smatch_profile.c */
+extern int option_profile_checks;
+extern char *option_profile_json;
+int __start_check_profile(int owner);
+void __stop_check_profile(int prev);
+void __profile_sm_state(int owner);
+void allocate_check_profile(void);
+void show_check_profile(void);
+
+static inline int start_check_profile(int owner)
+{
+	if (!option_profile_checks)
+		return 0;
+	return __start_check_profile(owner);
+}
+
+static inline void stop_check_profile(int prev)
+{
+	if (option_profile_checks)
+		__stop_check_profile(prev);
+}
+
+/* smatch_fork_server.c */
+extern char *option_fork_server;
+extern char *option_connect;
+int fork_server_client(const char *path, int argc, char **argv);
+void run_fork_server(const char *path, int *argcp, char ***argvp);
+
+/* smatch_inline_summary.c */
+void inline_summary_add_return(unsigned long call_id, int return_id,
+			       const char *return_ranges, int type, int param,
+			       const char *key, const char *value);
+void inline_summary_add_implies(unsigned long call_id, const char *function,
+				int type, int param, const char *key,
+				const char *value);
+void inline_summary_add_caller(unsigned long call_id, int type, int param,
+			       const char *key, const char *value);
+void inline_summary_select_returns(unsigned long call_id,
+				   int (*callback)(void*, int, char**, char**),
+				   void *data);
+void inline_summary_select_return_ranges(unsigned long call_id,
+					 int (*callback)(void*, int, char**, char**),
+					 void *data);
+void inline_summary_select_implies(unsigned long call_id,
+				   int (*callback)(void*, int, char**, char**),
+				   void *data);
+void inline_summary_select_callers(unsigned long call_id,
+				   int (*callback)(void*, int, char**, char**),
+				   void *data);
+void clear_inline_summaries(void);
+
+/* smatch_function_jobs.c */
+extern int option_function_jobs;
+bool in_function_job_worker(void);
+void function_job_add_inline(struct symbol *sym);
+void start_function_jobs(struct symbol_list *fns,
+			 void (*split)(struct symbol *sym),
+			 void (*add_inline)(struct symbol *sym));
+bool finish_function_job(struct symbol *sym);
+void end_function_jobs(void);
+
+/* smatch_state_intern.c */
+struct smatch_state *lookup_interned_state(int owner, unsigned int hash,
+		struct smatch_state *state,
+		bool (*same)(struct smatch_state *a, struct smatch_state *b));
+struct smatch_state *intern_state(int owner, unsigned int hash,
+		struct smatch_state *state,
+		bool (*same)(struct smatch_state *a, struct smatch_state *b));
+unsigned int hash_intern_str(unsigned int hash, const char *str);
+void clear_interned_states(void);
+void show_intern_state_stats(void);
+
 /* smatch_function_hooks.c */
 const char *get_fn_name(struct expression *fn);
 void add_fake_call_after_return(struct expression *call);
@@ -975,6 +1086,7 @@ enum early_late {
 extern struct sqlite3 *smatch_db;
 extern struct sqlite3 *mem_db;
 extern struct sqlite3 *cache_db;
+extern struct sqlite3 *shard_db;
 
 bool db_incomplete(void);
 void db_ignore_states(int id);
@@ -1015,7 +1127,9 @@ char *sm_to_arg_name(struct expression *expr, struct sm_state *sm);
 int is_recursive_member(const char *param_name);
 
 char *escape_newlines(const char *str);
+extern int option_db_stats;
 void sql_exec(struct sqlite3 *db, int (*callback)(void*, int, char**, char**), void *data, const char *sql);
+void show_db_stats(void);
 
 #define sql_helper(db, call_back, data, sql...)					\
 do {										\
@@ -1027,6 +1141,31 @@ do {										\
 } while (0)
 
 
+#define MAX_BINDS 4
+struct sql_bind {
+	int nr;
+	char type[MAX_BINDS];
+	long long ival[MAX_BINDS];
+	const char *sval[MAX_BINDS];
+};
+void sql_bind_int(struct sql_bind *bind, long long val);
+void sql_bind_text(struct sql_bind *bind, const char *str);
+void sql_exec_bound(struct sqlite3 *db, int (*callback)(void*, int, char**, char**),
+		    void *data, struct sql_bind *bind, const char *fmt, ...);
+
+#define run_sql_bound(call_back, data, bind, sql...)				\
+do {										\
+	if (option_no_db)							\
+		break;								\
+	sql_exec_bound(smatch_db, call_back, data, bind, sql);			\
+} while (0)
+
+#define mem_sql_bound(call_back, data, bind, sql...)				\
+	sql_exec_bound(mem_db, call_back, data, bind, sql)
+
+#define cache_sql_bound(call_back, data, bind, sql...)				\
+	sql_exec_bound(cache_db, call_back, data, bind, sql)
+
 #define run_sql(call_back, data, sql...)					\
 do {										\
 	if (option_no_db)							\
@@ -1044,8 +1183,9 @@ do {										\
 do {										\
 	struct sqlite3 *_db = db;						\
 										\
+	/* smatch_inline_summary.c has everything inlining needs */		\
 	if (__inline_fn && !_db)						\
-		_db = mem_db;							\
+		break;								\
 	if (_db) {								\
 		char buf[1024];							\
 		char *err, *p = buf;						\
@@ -1065,6 +1205,10 @@ do {										\
 		}								\
 		break;								\
 	}									\
+	if (option_info && shard_db) {						\
+		sql_insert_shard(#table, ignore, late, values);			\
+		break;								\
+	}									\
 	if (option_info) {							\
 		FILE *tmp_fd = sm_outfd;					\
 		sm_outfd = sql_outfd;						\
@@ -1122,6 +1266,11 @@ void sql_select_call_implies(const char *cols, struct expression *call,
 	int (*callback)(void*, int, char**, char**));
 
 void open_smatch_db(char *db_file);
+void reopen_smatch_db(char *db_file);
+void open_info_shard(const char *dir);
+void close_info_shard(void);
+void sql_save_shard(int late, const char *fmt, ...);
+void sql_insert_shard(const char *table, int ignore, int late, const char *fmt, ...);
 
 /* smatch_files.c */
 int open_data_file(const char *filename);
@@ -586,6 +586,7 @@ void register_bits(int id)
 	my_id = id;
 
 	set_dynamic_states(my_id);
+	func_scope_bit_info_alloc();
 
 	add_unmatched_state_hook(my_id, &unmatched_state);
 	add_merge_hook(my_id, &merge_bstates);
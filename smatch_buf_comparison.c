@@ -103,7 +103,7 @@ int state_to_limit(struct smatch_state *state)
 		return -1;
 
 	for (i = 0; i < ARRAY_SIZE(limit_map); i++) {
-		if (strncmp(state->name, limit_map[i], strlen(limit_map[i])) == 0)
+		if (strncmp(show_state(state), limit_map[i], strlen(limit_map[i])) == 0)
 			return i + BYTE_COUNT;
 	}
 
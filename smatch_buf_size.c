@@ -1055,7 +1055,7 @@ static void struct_member_callback(struct expression *call, int param, char *pri
 	    estate_max(sm->state).value == 0)
 		return;
 
-	sql_insert_caller_info(call, BUF_SIZE, param, printed_name, sm->state->name);
+	sql_insert_caller_info(call, BUF_SIZE, param, printed_name, show_state(sm->state));
 }
 
 /*
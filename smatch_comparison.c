@@ -66,6 +66,82 @@ static const char *show_comparison(int comparison)
 	return show_special(comparison);
 }
 
+static unsigned int hash_vsl(unsigned int hash, struct var_sym_list *vsl)
+{
+	struct var_sym *vs;
+
+	FOR_EACH_PTR(vsl, vs) {
+		hash = hash_intern_str(hash, vs->var);
+		hash = hash_mix(hash, (unsigned long)vs->sym);
+	} END_FOR_EACH_PTR(vs);
+	return hash;
+}
+
+static unsigned int hash_compare_data(struct compare_data *data)
+{
+	unsigned int hash = data->comparison;
+
+	hash = hash_mix(hash, (unsigned long)data->left);
+	hash = hash_intern_str(hash, data->left_var);
+	hash = hash_vsl(hash, data->left_vsl);
+	hash = hash_mix(hash, (unsigned long)data->right);
+	hash = hash_intern_str(hash, data->right_var);
+	hash = hash_vsl(hash, data->right_vsl);
+	return hash;
+}
+
+static bool same_str(const char *a, const char *b)
+{
+	if (!a || !b)
+		return a == b;
+	return strcmp(a, b) == 0;
+}
+
+static bool same_vsl(struct var_sym_list *one, struct var_sym_list *two)
+{
+	struct var_sym *one_vs, *two_vs;
+
+	PREPARE_PTR_LIST(one, one_vs);
+	PREPARE_PTR_LIST(two, two_vs);
+	for (;;) {
+		if (!one_vs || !two_vs)
+			return one_vs == two_vs;
+		if (one_vs->sym != two_vs->sym || !same_str(one_vs->var, two_vs->var))
+			return false;
+		NEXT_PTR_LIST(one_vs);
+		NEXT_PTR_LIST(two_vs);
+	}
+	FINISH_PTR_LIST(two_vs);
+	FINISH_PTR_LIST(one_vs);
+
+	return true;
+}
+
+static bool same_compare_state(struct smatch_state *one, struct smatch_state *two)
+{
+	struct compare_data *a = one->data;
+	struct compare_data *b = two->data;
+
+	return a->comparison == b->comparison &&
+	       a->left == b->left && a->right == b->right &&
+	       same_str(a->left_var, b->left_var) &&
+	       same_str(a->right_var, b->right_var) &&
+	       same_vsl(a->left_vsl, b->left_vsl) &&
+	       same_vsl(a->right_vsl, b->right_vsl);
+}
+
+static const char *render_compare_state(struct smatch_state *state)
+{
+	struct compare_data *data = state->data;
+
+	return alloc_sname(show_comparison(data->comparison));
+}
+
+/*
+ * The comparison states are never changed after they are created so they
+ * are interned.  Look it up first so we don't have to copy the var_sym
+ * lists when it already exists.
+ */
 struct smatch_state *alloc_compare_state(
 		struct expression *left,
 		const char *left_var, struct var_sym_list *left_vsl,
@@ -73,11 +149,27 @@ struct smatch_state *alloc_compare_state(
 		struct expression *right,
 		const char *right_var, struct var_sym_list *right_vsl)
 {
+	struct compare_data key = {
+		.left = left,
+		.left_var = left_var,
+		.left_vsl = left_vsl,
+		.comparison = comparison,
+		.right = right,
+		.right_var = right_var,
+		.right_vsl = right_vsl,
+	};
+	struct smatch_state tmp = { .data = &key };
 	struct smatch_state *state;
 	struct compare_data *data;
+	unsigned int hash;
+
+	hash = hash_compare_data(&key);
+	state = lookup_interned_state(comparison_id, hash, &tmp, same_compare_state);
+	if (state)
+		return state;
 
 	state = __alloc_smatch_state(0);
-	state->name = alloc_sname(show_comparison(comparison));
+	state->render = render_compare_state;
 	data = __alloc_compare_data(0);
 	data->left = left;
 	data->left_var = alloc_sname(left_var);
@@ -87,7 +179,7 @@ struct smatch_state *alloc_compare_state(
 	data->right_var = alloc_sname(right_var);
 	data->right_vsl = clone_var_sym_list(right_vsl);
 	state->data = data;
-	return state;
+	return intern_state(comparison_id, hash, state, same_compare_state);
 }
 
 int state_to_comparison(struct smatch_state *state)
@@ -577,15 +669,14 @@ struct smatch_state *merge_compare_states(struct smatch_state *s1, struct smatch
 			data->right, data->right_var, data->right_vsl);
 }
 
-static struct smatch_state *alloc_link_state(struct string_list *links)
+static const char *render_link_state(struct smatch_state *state)
 {
-	struct smatch_state *state;
+	struct string_list *links = state->data;
 	static char buf[256] = "";
 	int cnt = 0;
 	char *tmp;
 
-	state = __alloc_smatch_state(0);
-
+	buf[0] = '\0';
 	FOR_EACH_PTR(links, tmp) {
 		cnt += snprintf(buf + cnt, sizeof(buf) - cnt, "%s%s", cnt ? ", " : "", tmp);
 		if (cnt >= sizeof(buf))
@@ -593,7 +684,15 @@ static struct smatch_state *alloc_link_state(struct string_list *links)
 	} END_FOR_EACH_PTR(tmp);
 
 done:
-	state->name = alloc_sname(buf);
+	return alloc_sname(buf);
+}
+
+static struct smatch_state *alloc_link_state(struct string_list *links)
+{
+	struct smatch_state *state;
+
+	state = __alloc_smatch_state(0);
+	state->render = render_link_state;
 	state->data = links;
 	return state;
 }
@@ -2003,9 +2102,9 @@ struct state_list *get_all_possible_equal_comparisons(struct expression *expr)
 		sm = get_sm_state(comparison_id, tmp, NULL);
 		if (!sm)
 			continue;
-		if (!strchr(sm->state->name, '='))
+		if (!strchr(show_state(sm->state), '='))
 			continue;
-		if (strcmp(sm->state->name, "!=") == 0)
+		if (strcmp(show_state(sm->state), "!=") == 0)
 			continue;
 		add_ptr_list(&ret, sm);
 	} END_FOR_EACH_PTR(tmp);
@@ -2034,7 +2133,7 @@ struct state_list *get_all_possible_not_equal_comparisons(struct expression *exp
 		if (!sm)
 			continue;
 		FOR_EACH_PTR(sm->possible, possible) {
-			if (strcmp(possible->state->name, "!=") != 0)
+			if (strcmp(show_state(possible->state), "!=") != 0)
 				continue;
 			add_ptr_list(&ret, sm);
 			break;
@@ -2811,13 +2910,6 @@ int impossibly_high_comparison(struct expression *expr)
 	return 0;
 }
 
-static void free_data(struct symbol *sym)
-{
-	if (__inline_fn)
-		return;
-	clear_compare_data_alloc();
-}
-
 void register_comparison(int id)
 {
 	comparison_id = id;
@@ -2826,7 +2918,7 @@ void register_comparison(int id)
 	add_unmatched_state_hook(comparison_id, unmatched_comparison);
 	add_pre_merge_hook(comparison_id, &pre_merge_hook);
 	add_merge_hook(comparison_id, &merge_compare_states);
-	add_hook(&free_data, AFTER_FUNC_HOOK);
+	func_scope_compare_data_alloc();
 
 	add_hook(&match_call_info, FUNCTION_CALL_HOOK);
 	select_caller_name_sym(&select_caller_info, PARAM_COMPARE);
@@ -2956,7 +3048,7 @@ static void filter_by_sm(struct sm_state *sm, int op,
 	if (debug_implied()) {
 		sm_msg("%s: %s: op = '%s' negated '%s'. true_intersect = '%s' false_insersect = '%s' sm = '%s'",
 		       __func__,
-		       sm->state->name,
+		       show_state(sm->state),
 		       alloc_sname(show_comparison(op)),
 		       alloc_sname(show_comparison(negate_comparison(op))),
 		       alloc_sname(show_comparison(comparison_intersection(data->comparison, op))),
@@ -938,7 +938,7 @@ int __handle_expr_statement_assigns(struct expression *expr)
 	if (stmt->type == STMT_COMPOUND) {
 		struct statement *last_stmt;
 		struct expression *fake_assign;
-		struct expression fake_expr_stmt = { .smatch_flags = Fake, };
+		struct expression *fake_expr_stmt;
 
 		last_stmt = split_then_return_last(stmt);
 		if (!last_stmt) {
@@ -946,12 +946,15 @@ int __handle_expr_statement_assigns(struct expression *expr)
 			return 0;
 		}
 
-		fake_expr_stmt.pos = last_stmt->pos;
-		fake_expr_stmt.type = EXPR_STATEMENT;
-		fake_expr_stmt.op = 0;
-		fake_expr_stmt.statement = last_stmt;
+		/*
+		 * Don't put this on the stack.  The expression caches are
+		 * keyed by pointer so the address must not be reused.
+		 */
+		fake_expr_stmt = alloc_expression(last_stmt->pos, EXPR_STATEMENT);
+		fake_expr_stmt->smatch_flags = Fake;
+		fake_expr_stmt->statement = last_stmt;
 
-		fake_assign = assign_expression(expr->left, expr->op, &fake_expr_stmt);
+		fake_assign = assign_expression(expr->left, expr->op, fake_expr_stmt);
 		fake_assign = add_casts(cast, fake_assign);
 		expr_set_parent_expr(fake_assign, expr);
 		__split_expr(fake_assign);
@@ -136,7 +136,7 @@ static struct smatch_state *merge_func(struct smatch_state *s1, struct smatch_st
 	struct constraint_list *list;
 
 	// FIXME:  use the dead code below instead
-	if (strcmp(s1->name, s2->name) == 0)
+	if (strcmp(show_state(s1), show_state(s2)) == 0)
 		return s1;
 	return &merged;
 
@@ -418,7 +418,7 @@ static void match_caller_info(struct expression *expr)
 		state = get_state_expr(my_id, tmp);
 		if (!state || state == &merged || state == &undefined)
 			continue;
-		sql_insert_caller_info(expr, CONSTRAINT, i, "$", state->name);
+		sql_insert_caller_info(expr, CONSTRAINT, i, "$", show_state(state));
 	} END_FOR_EACH_PTR(tmp);
 }
 
@@ -426,7 +426,7 @@ static void struct_member_callback(struct expression *call, int param, char *pri
 {
 	if (sm->state == &merged || sm->state == &undefined)
 		return;
-	sql_insert_caller_info(call, CONSTRAINT, param, printed_name, sm->state->name);
+	sql_insert_caller_info(call, CONSTRAINT, param, printed_name, show_state(sm->state));
 }
 
 static struct smatch_state *constraint_str_to_state(char *value)
@@ -487,7 +487,7 @@ static void print_return_implies_constrained(int return_id, char *return_ranges,
 			continue;
 
 		orig = get_state_stree(get_start_states(), my_id, sm->name, sm->sym);
-		if (orig && strcmp(sm->state->name, orig->name) == 0)
+		if (orig && strcmp(show_state(sm->state), show_state(orig)) == 0)
 			continue;
 
 		param_name = get_param_name(sm);
@@ -495,7 +495,7 @@ static void print_return_implies_constrained(int return_id, char *return_ranges,
 			continue;
 
 		sql_insert_return_states(return_id, return_ranges, CONSTRAINT,
-					 param, param_name, sm->state->name);
+					 param, param_name, show_state(sm->state));
 	} END_FOR_EACH_SM(sm);
 }
 
@@ -518,6 +518,7 @@ void register_constraints(int id)
 	my_id = id;
 
 	set_dynamic_states(my_id);
+	func_scope_constraint_alloc();
 	add_merge_hook(my_id, &merge_func);
 	add_hook(&match_condition, CONDITION_HOOK);
 
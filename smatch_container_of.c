@@ -204,7 +204,7 @@ static char *get_stored_container_name(struct expression *container,
 	if (!state)
 		return NULL;
 
-	snprintf(buf, sizeof(buf), "%s", state->name);
+	snprintf(buf, sizeof(buf), "%s", show_state(state));
 	p = strchr(buf, '|');
 	if (!p)
 		return NULL;
@@ -617,7 +617,7 @@ static void handle_passed_container(struct symbol *sym)
 		state = get_state(param_id, arg->ident->name, arg);
 		if (!state || state == &merged)
 			continue;
-		load_container_data(arg, state->name);
+		load_container_data(arg, show_state(state));
 	} END_FOR_EACH_PTR(arg);
 }
 
@@ -27,6 +27,8 @@ rm -f $db_file
 for i in ${bin_dir}/*.schema ; do
     cat $i | sqlite3 $db_file
 done
+# the DB format, see smatch_hash.c
+echo "PRAGMA user_version = 2;" | sqlite3 $db_file
 
 ${bin_dir}/init_constraints.pl "$PROJ" $info_file $db_file
 ${bin_dir}/init_constraints_required.pl "$PROJ" $info_file $db_file
@@ -34,6 +36,12 @@ ${bin_dir}/fill_db_sql.pl "$PROJ" $info_file $db_file
 if [ -e ${info_file}.sql ] ; then
     ${bin_dir}/fill_db_sql.pl "$PROJ" ${info_file}.sql $db_file
 fi
+shopt -s nullglob
+shards=("${info_file}".shards/*.sqlite)
+shopt -u nullglob
+if [ ${#shards[@]} -gt 0 ] ; then
+    ${bin_dir}/sm_merge_shards $db_file "${shards[@]}"
+fi
 ${bin_dir}/fill_db_caller_info.pl "$PROJ" $info_file $db_file
 if [ -e ${info_file}.caller_info ] ; then
     ${bin_dir}/fill_db_caller_info.pl "$PROJ" ${info_file}.caller_info $db_file
@@ -0,0 +1,150 @@
+#!/usr/bin/python3
+
+# Copyright (C) 2026 Oracle.
+#
+# Licensed under the Open Software License version 1.1
+
+# Convert a DB from format v1 (SHA-1 hashes) to format v2 (see smatch_hash.c)
+# without rebuilding it.
+#
+# The file ids can all be converted because every hashed file name is saved
+# in the hash_string table.  The mtags are only saved as hashes but the
+# strings for the allocation and global variable mtags can be rebuilt from
+# mtag_about.  The other mtags (string literals, aliases, local variables)
+# are left alone and they are fixed the next time the DB is rebuilt.
+#
+# Usage: rekey_hashes.py [smatch_db.sqlite]
+
+import hashlib
+import os
+import sqlite3
+import subprocess
+import sys
+
+script_dir = os.path.dirname(os.path.abspath(sys.argv[0]))
+sm_hash = os.path.join(script_dir, "sm_hash")
+
+DB_FORMAT = 2
+ALIAS_BIT = 1 << 63
+OFFSET_MASK = 0xfff
+
+def old_hash(s):
+    digest = hashlib.sha1(s.encode(errors="surrogateescape")).digest()
+    return int.from_bytes(digest[:8], "little") & ~ALIAS_BIT
+
+def new_hashes(strings):
+    ret = {}
+    strings = list(strings)
+    for i in range(0, len(strings), 1000):
+        chunk = strings[i:i + 1000]
+        out = subprocess.run([sm_hash] + chunk, capture_output=True,
+                             text=True, check=True).stdout.split()
+        for s, h in zip(chunk, out):
+            ret[s] = int(h)
+    return ret
+
+# SQLite integers are signed
+def to_db(val):
+    return val - (1 << 64) if val >= (1 << 63) else val
+
+def from_db(val):
+    return val + (1 << 64) if val < 0 else val
+
+def int_columns(con, column):
+    tables = []
+    for (table,) in con.execute("select name from sqlite_master where type = 'table';"):
+        cols = [row[1] for row in con.execute("pragma table_info(%s);" % table)]
+        if column in cols:
+            tables.append(table)
+    return tables
+
+def rekey_column(con, table, column, mapping, mask=0):
+    # the old and new hashes could overlap so go through a temp table
+    con.execute("drop table if exists rekey_map;")
+    con.execute("create temp table rekey_map (old integer primary key, new integer);")
+    con.executemany("insert into rekey_map values (?, ?);",
+                    [(to_db(o), to_db(n)) for o, n in mapping.items()])
+    if mask:
+        expr = "(%s & ~%d)" % (column, mask)
+        new = "(select new from rekey_map where old = %s) | (%s & %d)" % (expr, column, mask)
+    else:
+        expr = column
+        new = "(select new from rekey_map where old = %s)" % expr
+    # a UNIQUE conflict raises an error instead of leaving the row on the old hash
+    cur = con.execute("update %s set %s = %s where typeof(%s) = 'integer' and "
+                      "%s in (select old from rekey_map);" %
+                      (table, column, new, column, expr))
+    con.execute("drop table rekey_map;")
+    return cur.rowcount
+
+def file_mapping(con):
+    strings = [row[0] for row in con.execute("select distinct value from hash_string;")]
+    new = new_hashes(strings)
+    mapping = {}
+    for s in strings:
+        mapping[old_hash(s)] = new[s]
+    return mapping
+
+def mtag_strings(con):
+    strings = set()
+    for tag, left, right in con.execute(
+            "select distinct tag, left_name, right_name from mtag_about;"):
+        tag = from_db(tag)
+        for s in (right, "%s %s" % (right, left)):
+            if s is not None and old_hash(s) & ~OFFSET_MASK == tag:
+                strings.add(s)
+    return strings
+
+def mtag_mapping(con):
+    strings = mtag_strings(con)
+    new = new_hashes(strings)
+    return {old_hash(s) & ~OFFSET_MASK: new[s] & ~OFFSET_MASK for s in strings}
+
+def rekey(con):
+    files = file_mapping(con)
+    for table in int_columns(con, "file"):
+        n = rekey_column(con, table, "file", files)
+        print("%s.file: %d rows" % (table, n))
+    n = rekey_column(con, "hash_string", "hash", files)
+    print("hash_string.hash: %d rows" % n)
+
+    tags = mtag_mapping(con)
+    for table, column in (("mtag_about", "tag"), ("mtag_info", "tag"),
+                          ("mtag_data", "tag"), ("mtag_map", "container"),
+                          ("mtag_map", "tag"), ("mtag_alias", "orig")):
+        n = rekey_column(con, table, column, tags, OFFSET_MASK)
+        print("%s.%s: %d rows" % (table, column, n))
+
+def main():
+    db_file = sys.argv[1] if len(sys.argv) > 1 else "smatch_db.sqlite"
+    if not os.path.exists(db_file):
+        print("%s: no such file" % db_file)
+        sys.exit(1)
+
+    con = sqlite3.connect(db_file)
+    version = con.execute("pragma user_version;").fetchone()[0]
+    if version >= DB_FORMAT:
+        print("%s is already DB format %d" % (db_file, version))
+        return
+
+    try:
+        rekey(con)
+    except sqlite3.IntegrityError as e:
+        con.rollback()
+        con.close()
+        print("%s: %s" % (db_file, e))
+        print("%s was not changed.  Rebuild it instead." % db_file)
+        sys.exit(1)
+
+    left = con.execute("select count(distinct tag) from mtag_data where (tag & ~%d) "
+                       "not in (select new from (select distinct (tag & ~%d) as new "
+                       "from mtag_about));" % (OFFSET_MASK, OFFSET_MASK)).fetchone()[0]
+    if left:
+        print("%d mtags could not be converted.  They are updated when the DB is rebuilt." % left)
+
+    con.execute("pragma user_version = %d;" % DB_FORMAT)
+    con.commit()
+    con.close()
+
+if __name__ == "__main__":
+    main()
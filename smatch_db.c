@@ -17,8 +17,11 @@
 
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <limits.h>
+#include <stdarg.h>
 #include "smatch.h"
 #include "smatch_slist.h"
 #include "smatch_extra.h"
@@ -150,8 +153,22 @@ static int print_sql_output(void *unused, int argc, char **argv, char **azColNam
 	return 0;
 }
 
+static unsigned long unprepared_count;
+static unsigned long long unprepared_usec;
+static unsigned long return_cache_rows;
+static unsigned long return_cache_hits, return_cache_misses;
+
+static unsigned long long usec_since(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000000ULL + now.tv_usec - start->tv_usec;
+}
+
 void sql_exec(struct sqlite3 *db, int (*callback)(void*, int, char**, char**), void *data, const char *sql)
 {
+	struct timeval start;
 	char *err = NULL;
 	int rc;
 
@@ -164,7 +181,13 @@ void sql_exec(struct sqlite3 *db, int (*callback)(void*, int, char**, char**), v
 			sqlite3_exec(db, sql, print_sql_output, NULL, NULL);
 	}
 
+	if (option_db_stats)
+		gettimeofday(&start, NULL);
 	rc = sqlite3_exec(db, sql, callback, data, &err);
+	if (option_db_stats) {
+		unprepared_count++;
+		unprepared_usec += usec_since(&start);
+	}
 	if (rc != SQLITE_OK && !parse_error) {
 		sm_ierror("%s:%d SQL error #2: %s\n", get_filename(), get_lineno(), err);
 		sm_ierror("%s:%d SQL: '%s'\n", get_filename(), get_lineno(), sql);
@@ -172,6 +195,229 @@ void sql_exec(struct sqlite3 *db, int (*callback)(void*, int, char**, char**), v
 	}
 }
 
+/*
+ * The selects which are done for every function call only differ in the
+ * function name, the file and the call_id.  Instead of formatting and
+ * parsing new SQL every time, the query shape is prepared once with '?'
+ * place holders and the values are bound to it.  The %s and %d formats
+ * are still expanded the normal way so they should only be used for things
+ * like column lists which don't change much.
+ */
+struct db_stmt {
+	struct sqlite3 *db;
+	char *sql;
+	sqlite3_stmt *stmt;
+	int busy;
+	unsigned long count;
+	unsigned long long usec;
+	struct db_stmt *next;
+};
+
+#define DB_STMT_HASH 256
+static struct db_stmt *db_stmt_hash[DB_STMT_HASH];
+
+void sql_bind_int(struct sql_bind *bind, long long val)
+{
+	if (bind->nr >= MAX_BINDS)
+		sm_fatal("%s: too many binds", __func__);
+	bind->type[bind->nr] = 'i';
+	bind->ival[bind->nr] = val;
+	bind->nr++;
+}
+
+void sql_bind_text(struct sql_bind *bind, const char *str)
+{
+	if (bind->nr >= MAX_BINDS)
+		sm_fatal("%s: too many binds", __func__);
+	bind->type[bind->nr] = 's';
+	bind->sval[bind->nr] = str;
+	bind->nr++;
+}
+
+static bool is_local(struct symbol *sym);
+
+/* This is the same as get_static_filter() but with the values bound. */
+static const char *bind_static_filter(struct sql_bind *bind, struct symbol *sym)
+{
+	/* This can only happen on buggy code.  Return invalid SQL. */
+	if (!sym)
+		return "";
+
+	if (is_local(sym)) {
+		sql_bind_int(bind, get_base_file_id());
+		sql_bind_text(bind, sym->ident->name);
+		return "file = ? and function = ? and static = '1'";
+	}
+	sql_bind_text(bind, sym->ident->name);
+	return "function = ? and static = '0'";
+}
+
+static unsigned int sql_hash(struct sqlite3 *db, const char *sql)
+{
+	unsigned long hash = (unsigned long)db;
+
+	while (*sql)
+		hash = hash * 33 + *sql++;
+	return hash % DB_STMT_HASH;
+}
+
+static struct db_stmt *get_db_stmt(struct sqlite3 *db, const char *sql)
+{
+	struct db_stmt *tmp;
+	unsigned int hash;
+
+	hash = sql_hash(db, sql);
+	for (tmp = db_stmt_hash[hash]; tmp; tmp = tmp->next) {
+		if (tmp->db == db && strcmp(tmp->sql, sql) == 0)
+			return tmp;
+	}
+
+	tmp = calloc(1, sizeof(*tmp));
+	if (!tmp)
+		sm_fatal("%s: out of memory", __func__);
+	tmp->db = db;
+	tmp->sql = alloc_string(sql);
+	tmp->next = db_stmt_hash[hash];
+	db_stmt_hash[hash] = tmp;
+	return tmp;
+}
+
+static void sql_error(struct sqlite3 *db, int rc, const char *sql)
+{
+	if (parse_error)
+		return;
+	sm_ierror("%s:%d SQL error #2: %s\n", get_filename(), get_lineno(),
+		  rc == SQLITE_ABORT ? sqlite3_errstr(rc) : sqlite3_errmsg(db));
+	sm_ierror("%s:%d SQL: '%s'\n", get_filename(), get_lineno(), sql);
+	parse_error = 1;
+}
+
+static int step_stmt(sqlite3_stmt *stmt, int (*callback)(void*, int, char**, char**), void *data)
+{
+	char *argv[32], *names[32];
+	int cols, i, rc;
+
+	cols = sqlite3_column_count(stmt);
+	if (cols > ARRAY_SIZE(argv))
+		return SQLITE_TOOBIG;
+
+	while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+		if (!callback)
+			continue;
+		for (i = 0; i < cols; i++) {
+			argv[i] = (char *)sqlite3_column_text(stmt, i);
+			names[i] = (char *)sqlite3_column_name(stmt, i);
+		}
+		if (callback(data, cols, argv, names))
+			return SQLITE_ABORT;
+	}
+	if (rc == SQLITE_DONE)
+		return SQLITE_OK;
+	return rc;
+}
+
+void sql_exec_bound(struct sqlite3 *db, int (*callback)(void*, int, char**, char**),
+		    void *data, struct sql_bind *bind, const char *fmt, ...)
+{
+	struct db_stmt *cache;
+	sqlite3_stmt *stmt;
+	struct timeval start;
+	char sql[1024];
+	va_list args;
+	int i, rc;
+
+	if (!db)
+		return;
+
+	va_start(args, fmt);
+	sqlite3_vsnprintf(sizeof(sql), sql, fmt, args);
+	va_end(args);
+
+	cache = get_db_stmt(db, sql);
+	if (!cache->stmt) {
+		rc = sqlite3_prepare_v2(db, sql, -1, &cache->stmt, NULL);
+		if (rc != SQLITE_OK) {
+			sql_error(db, rc, sql);
+			return;
+		}
+	}
+
+	/*
+	 * The callbacks sometimes do more selects.  If this shape is already
+	 * in use further up the stack then use a temporary copy of it.
+	 */
+	stmt = cache->stmt;
+	if (cache->busy) {
+		rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+		if (rc != SQLITE_OK) {
+			sql_error(db, rc, sql);
+			return;
+		}
+	}
+	cache->busy++;
+
+	for (i = 0; i < bind->nr; i++) {
+		if (bind->type[i] == 'i')
+			sqlite3_bind_int64(stmt, i + 1, bind->ival[i]);
+		else
+			sqlite3_bind_text(stmt, i + 1, bind->sval[i], -1, SQLITE_STATIC);
+	}
+
+	if (option_debug || debug_db) {
+		char *expanded = sqlite3_expanded_sql(stmt);
+
+		db_debug("debug: %s\n", expanded);
+		sm_msg("%s", expanded);
+		if (sqlite3_stmt_readonly(stmt)) {
+			step_stmt(stmt, print_sql_output, NULL);
+			sqlite3_reset(stmt);
+		}
+		sqlite3_free(expanded);
+	}
+
+	if (option_db_stats)
+		gettimeofday(&start, NULL);
+	rc = step_stmt(stmt, callback, data);
+	if (option_db_stats) {
+		cache->count++;
+		cache->usec += usec_since(&start);
+	}
+	if (rc != SQLITE_OK) {
+		char *expanded = sqlite3_expanded_sql(stmt);
+
+		sql_error(db, rc, expanded);
+		sqlite3_free(expanded);
+	}
+
+	cache->busy--;
+	if (stmt != cache->stmt) {
+		sqlite3_finalize(stmt);
+	} else {
+		sqlite3_reset(stmt);
+		sqlite3_clear_bindings(stmt);
+	}
+}
+
+void show_db_stats(void)
+{
+	struct db_stmt *tmp;
+	int i;
+
+	for (i = 0; i < DB_STMT_HASH; i++) {
+		for (tmp = db_stmt_hash[i]; tmp; tmp = tmp->next) {
+			if (!tmp->count)
+				continue;
+			sm_msg("db_stats: %s %lu calls %llu ms: %s",
+			       tmp->db == mem_db ? "mem" : "db", tmp->count,
+			       tmp->usec / 1000, tmp->sql);
+		}
+	}
+	sm_msg("db_stats: unprepared %lu calls %llu ms",
+	       unprepared_count, unprepared_usec / 1000);
+	sm_msg("db_stats: return_states cache hits %lu misses %lu rows %lu",
+	       return_cache_hits, return_cache_misses, return_cache_rows);
+}
+
 static int replace_count;
 static char **replace_table;
 static const char *replace_return_ranges(const char *return_ranges)
@@ -293,10 +539,12 @@ void sql_insert_return_states(int return_id, const char *return_ranges,
 
 	if (key && strlen(key) >= 80)
 		return;
-	if (__inline_fn)
-		id = (unsigned long)__inline_fn;
-	else
-		id = __fn_mtag;
+	if (__inline_fn) {
+		inline_summary_add_return((unsigned long)__inline_fn, return_id,
+					  return_ranges, type, param, key, value);
+		return;
+	}
+	id = __fn_mtag;
 
 	sql_insert(return_states, "0x%llx, '%s', %llu, %d, '%s', %d, %d, %d, '%s', '%s'",
 		   get_base_file_id(), get_function(), id, return_id,
@@ -345,12 +593,8 @@ void sql_insert_caller_info(struct expression *call, int type,
 	if (!fn)
 		return;
 
-	if (__inline_call) {
-		mem_sql(NULL, NULL,
-			"insert into caller_info values (0x%llx, '%s', '%s', %lu, %d, %d, %d, '%s', '%s');",
-			get_base_file_id(), get_function(), fn, (unsigned long)call,
-			is_static(call->fn), type, param, key, value);
-	}
+	if (__inline_call)
+		inline_summary_add_caller((unsigned long)call, type, param, key, value);
 
 	if (!option_info)
 		return;
@@ -383,10 +627,12 @@ void sql_insert_return_implies(int type, int param, const char *key, const char
 	if (in_ignored_macro())
 		return;
 
-	if (__inline_fn)
-		id = (unsigned long)__inline_fn;
-	else
-		id = __fn_mtag;
+	if (__inline_fn) {
+		inline_summary_add_implies((unsigned long)__inline_fn,
+					   get_function(), type, param, key, value);
+		return;
+	}
+	id = __fn_mtag;
 
 	sql_insert_or_ignore(return_implies, "0x%llx, '%s', %llu, %d, %d, %d, '%s', '%s'",
 		get_base_file_id(), get_function(), id, fn_static(), type,
@@ -395,6 +641,9 @@ void sql_insert_return_implies(int type, int param, const char *key, const char
 
 void sql_insert_call_implies(int type, int param, const char *key, const char *value)
 {
+	/* nothing looks up the call_implies for inlined calls */
+	if (__inline_fn)
+		return;
 	sql_insert_or_ignore(call_implies, "0x%llx, '%s', %lu, %d, %d, %d, '%s', '%s'",
 		get_base_file_id(), get_function(), (unsigned long)__inline_fn,
 		fn_static(), type, param, key, value);
@@ -461,6 +710,11 @@ void sql_save_constraint(const char *con)
 	if (!option_info)
 		return;
 
+	if (shard_db) {
+		sql_save_shard(0, "insert or ignore into constraints (str) values('%s');",
+			       escape_newlines(con));
+		return;
+	}
         sm_msg("SQL: insert or ignore into constraints (str) values('%s');", escape_newlines(con));
 }
 
@@ -474,6 +728,12 @@ void sql_copy_constraint_required(const char *new_limit, const char *old_limit)
 	if (!option_info)
 		return;
 
+	if (shard_db) {
+		sql_save_shard(1, "insert or ignore into constraints_required (data, op, bound) "
+			"select constraints_required.data, constraints_required.op, '%s' from "
+			"constraints_required where bound = '%s';", new_limit, old_limit);
+		return;
+	}
 	sm_msg("SQL_late: insert or ignore into constraints_required (data, op, bound) "
 		"select constraints_required.data, constraints_required.op, '%s' from "
 		"constraints_required where bound = '%s';", new_limit, old_limit);
@@ -628,38 +888,249 @@ struct string_list *get_caller_ptrs(struct symbol *sym)
 	return list;
 }
 
+/*
+ * The same callees like kmalloc() or mutex_lock() are called hundreds of
+ * times per file.  The DB doesn't change while we're parsing so the
+ * return_states rows are cached the first time a callee is looked up and
+ * then handed to the callback from memory after that.  The range strings
+ * are still parsed for each call because they can refer to the arguments
+ * of the call ("$0" etc).
+ */
+struct return_cache {
+	char *key;
+	int row_count;
+	int cols;
+	int nr_rows;
+	int max_rows;
+	char **argv;
+	char **names;
+	struct return_cache *next;
+};
+
+#define RETURN_CACHE_HASH 1024
+#define RETURN_CACHE_MAX_ROWS 500000
+static struct return_cache *return_cache_hash[RETURN_CACHE_HASH];
+static int return_cache_busy;
+
+static unsigned int return_cache_hash_key(const char *key)
+{
+	unsigned long hash = 5381;
+
+	while (*key)
+		hash = hash * 33 + *key++;
+	return hash % RETURN_CACHE_HASH;
+}
+
+static void free_return_cache(struct return_cache *cache)
+{
+	int i;
+
+	for (i = 0; i < cache->nr_rows * cache->cols; i++)
+		free(cache->argv[i]);
+	for (i = 0; cache->names && i < cache->cols; i++)
+		free(cache->names[i]);
+	free(cache->argv);
+	free(cache->names);
+	free(cache->key);
+	free(cache);
+}
+
+static void clear_return_cache(void)
+{
+	struct return_cache *cache, *next;
+	int i;
+
+	for (i = 0; i < RETURN_CACHE_HASH; i++) {
+		for (cache = return_cache_hash[i]; cache; cache = next) {
+			next = cache->next;
+			free_return_cache(cache);
+		}
+		return_cache_hash[i] = NULL;
+	}
+	return_cache_rows = 0;
+}
+
+/*
+ * The key is the query plus whatever values are bound to it.  The file id
+ * is bound for static functions so they aren't shared between files.
+ */
+static char *return_cache_key(const char *cols, const char *query,
+			      struct sql_bind *bind)
+{
+	char buf[1024];
+	int i, n;
+
+	n = snprintf(buf, sizeof(buf), "%s|%s", cols, query);
+	for (i = 0; i < bind->nr && n < sizeof(buf); i++) {
+		if (bind->type[i] == 'i')
+			n += snprintf(buf + n, sizeof(buf) - n, "|%lld", bind->ival[i]);
+		else
+			n += snprintf(buf + n, sizeof(buf) - n, "|%s", bind->sval[i]);
+	}
+	if (n >= sizeof(buf))
+		return NULL;
+	return strdup(buf);
+}
+
+/*
+ * Returns a cached entry or a new empty one.  The new ones have to be
+ * filled in and passed to add_return_cache().  When we are debugging the
+ * queries are always done so that the SQL is printed every time.
+ */
+static struct return_cache *get_return_cache(const char *cols, const char *query,
+					      struct sql_bind *bind, bool *found)
+{
+	struct return_cache *cache;
+	char *key;
+
+	*found = false;
+	key = NULL;
+	if (!option_debug && !debug_db)
+		key = return_cache_key(cols, query, bind);
+	if (key) {
+		for (cache = return_cache_hash[return_cache_hash_key(key)]; cache;
+		     cache = cache->next) {
+			if (strcmp(cache->key, key) == 0) {
+				free(key);
+				return_cache_hits++;
+				*found = true;
+				return cache;
+			}
+		}
+		return_cache_misses++;
+	}
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		sm_fatal("%s: out of memory", __func__);
+	cache->key = key;
+	return cache;
+}
+
+static void add_return_cache(struct return_cache *cache)
+{
+	unsigned int hash;
+
+	if (!cache->key)
+		return;
+
+	/* Don't free rows which are still being passed to a callback. */
+	if (return_cache_rows + cache->nr_rows > RETURN_CACHE_MAX_ROWS &&
+	    !return_cache_busy)
+		clear_return_cache();
+
+	hash = return_cache_hash_key(cache->key);
+	cache->next = return_cache_hash[hash];
+	return_cache_hash[hash] = cache;
+	return_cache_rows += cache->nr_rows;
+}
+
+static char *dup_column(const char *str)
+{
+	char *ret;
+
+	if (!str)
+		return NULL;
+	ret = strdup(str);
+	if (!ret)
+		sm_fatal("out of memory");
+	return ret;
+}
+
+static int save_return_row(void *_cache, int argc, char **argv, char **azColName)
+{
+	struct return_cache *cache = _cache;
+	char **row;
+	int i;
+
+	if (!cache->names) {
+		cache->cols = argc;
+		cache->names = calloc(argc, sizeof(char *));
+		if (!cache->names)
+			sm_fatal("%s: out of memory", __func__);
+		for (i = 0; i < argc; i++)
+			cache->names[i] = dup_column(azColName[i]);
+	}
+	if (argc != cache->cols)
+		return 0;
+
+	if (cache->nr_rows == cache->max_rows) {
+		cache->max_rows = cache->max_rows ? cache->max_rows * 2 : 8;
+		cache->argv = realloc(cache->argv,
+				      cache->max_rows * cache->cols * sizeof(char *));
+		if (!cache->argv)
+			sm_fatal("%s: out of memory", __func__);
+	}
+	row = &cache->argv[cache->nr_rows * cache->cols];
+	for (i = 0; i < argc; i++)
+		row[i] = dup_column(argv[i]);
+	cache->nr_rows++;
+	return 0;
+}
+
+static void replay_return_cache(struct return_cache *cache,
+	int (*callback)(void*, int, char**, char**), void *info)
+{
+	int i;
+
+	return_cache_busy++;
+	for (i = 0; i < cache->nr_rows; i++) {
+		if (callback(info, cache->cols, &cache->argv[i * cache->cols],
+			     cache->names)) {
+			sql_error(smatch_db, SQLITE_ABORT, cache->key ?: "return_states");
+			break;
+		}
+	}
+	return_cache_busy--;
+
+	if (!cache->key)
+		free_return_cache(cache);
+}
+
 static void sql_select_return_states_pointer(const char *cols,
 	struct expression *call, int (*callback)(void*, int, char**, char**), void *info)
 {
+	struct return_cache *cache;
+	struct sql_bind bind = {};
+	int return_count;
 	char *ptr;
-	int return_count = 0;
+	bool found;
 
 	ptr = get_fnptr_name(call->fn);
 	if (!ptr)
 		return;
 
-	run_sql(get_row_count, &return_count,
+	sql_bind_text(&bind, ptr);
+	cache = get_return_cache(cols, "ptr", &bind, &found);
+	if (found)
+		goto replay;
+
+	run_sql_bound(get_row_count, &cache->row_count, &bind,
 		"select count(*) from return_states join function_ptr "
 		"where return_states.function == function_ptr.function and "
-		"ptr = '%s' and searchable = 1 and type = %d;", ptr, INTERNAL);
+		"ptr = ? and searchable = 1 and type = %d;", INTERNAL);
 	/* The magic number 100 is just from testing on the kernel. */
-	if (return_count == 0 || return_count > 100) {
-		run_sql(callback, info,
+	if (cache->row_count == 0 || cache->row_count > 100) {
+		run_sql_bound(save_return_row, cache, &bind,
 			"select distinct %s from return_states join function_ptr where "
-			"return_states.function == function_ptr.function and ptr = '%s' "
+			"return_states.function == function_ptr.function and ptr = ? "
 			"and searchable = 1 and type = %d "
 			"order by function_ptr.file, return_states.file, return_id, type;",
-			cols, ptr, INTERNAL);
-		mark_call_params_untracked(call);
-		return;
+			cols, INTERNAL);
+	} else {
+		run_sql_bound(save_return_row, cache, &bind,
+			"select %s from return_states join function_ptr where "
+			"return_states.function == function_ptr.function and ptr = ? "
+			"and searchable = 1 "
+			"order by function_ptr.file, return_states.file, return_id, type;",
+			cols);
 	}
-
-	run_sql(callback, info,
-		"select %s from return_states join function_ptr where "
-		"return_states.function == function_ptr.function and ptr = '%s' "
-		"and searchable = 1 "
-		"order by function_ptr.file, return_states.file, return_id, type;",
-		cols, ptr);
+	add_return_cache(cache);
+replay:
+	return_count = cache->row_count;
+	replay_return_cache(cache, callback, info);
+	if (return_count == 0 || return_count > 100)
+		mark_call_params_untracked(call);
 }
 
 static int is_local_symbol(struct expression *expr)
@@ -693,8 +1164,12 @@ static void clear_incomplete(struct symbol *sym)
 void sql_select_return_states(const char *cols, struct expression *call,
 	int (*callback)(void*, int, char**, char**), void *info)
 {
+	struct return_cache *cache;
+	struct sql_bind bind = {};
 	struct expression *fn;
-	int row_count = 0;
+	const char *filter;
+	int row_count;
+	bool found;
 
 	if (is_fake_call(call))
 		return;
@@ -706,14 +1181,24 @@ void sql_select_return_states(const char *cols, struct expression *call,
 	}
 
 	if (inlinable(fn)) {
-		mem_sql(callback, info,
-			"select %s from return_states where call_id = '%lu' order by return_id, type;",
-			cols, (unsigned long)call);
+		if (strcmp(cols, "return_id, return, type, parameter, key, value") != 0)
+			sm_ierror("%s: unexpected columns '%s'", __func__, cols);
+		inline_summary_select_returns((unsigned long)call, callback, info);
 		return;
 	}
 
-	run_sql(get_row_count, &row_count, "select count(*) from return_states where %s;",
-		get_static_filter(fn->symbol));
+	filter = bind_static_filter(&bind, fn->symbol);
+	cache = get_return_cache(cols, filter, &bind, &found);
+	if (!found) {
+		run_sql_bound(get_row_count, &cache->row_count, &bind,
+			      "select count(*) from return_states where %s;", filter);
+		if (cache->row_count > 0 && cache->row_count <= 3000)
+			run_sql_bound(save_return_row, cache, &bind,
+				      "select %s from return_states where %s order by file, return_id, type;",
+				      cols, filter);
+		add_return_cache(cache);
+	}
+	row_count = cache->row_count;
 
 	/*
 	 * FIXME: This isn't right.  We want to check that everything we
@@ -725,12 +1210,13 @@ void sql_select_return_states(const char *cols, struct expression *call,
 	    !(fn->symbol->ident && strncmp(fn->symbol->ident->name, "__smatch", 8)))
 		__db_incomplete = true;
 	if (row_count == 0 || row_count > 3000) {
+		if (!cache->key)
+			free_return_cache(cache);
 		mark_call_params_untracked(call);
 		return;
 	}
 
-	run_sql(callback, info, "select %s from return_states where %s order by file, return_id, type;",
-		cols, get_static_filter(fn->symbol));
+	replay_return_cache(cache, callback, info);
 }
 
 bool db_incomplete(void)
@@ -753,17 +1239,19 @@ struct implies_info {
 void sql_select_implies(const char *cols, struct implies_info *info,
 	int (*callback)(void*, int, char**, char**))
 {
+	struct sql_bind bind = {};
+	const char *filter;
+
 	if (info->type == RETURN_IMPLIES && inlinable(info->expr->fn)) {
-		mem_sql(callback, info,
-			"select %s from return_implies where call_id = '%lu';",
-			cols, (unsigned long)info->expr);
+		inline_summary_select_implies((unsigned long)info->expr, callback, info);
 		return;
 	}
 
-	run_sql(callback, info, "select %s from %s_implies where %s;",
+	filter = bind_static_filter(&bind, info->sym);
+	run_sql_bound(callback, info, &bind, "select %s from %s_implies where %s;",
 		cols,
 		info->type == CALL_IMPLIES ? "call" : "return",
-		get_static_filter(info->sym));
+		filter);
 }
 
 struct select_caller_info_data {
@@ -778,11 +1266,13 @@ static int caller_info_callback(void *_data, int argc, char **argv, char **azCol
 
 static bool too_much_caller_info_data(struct symbol *sym)
 {
+	struct sql_bind bind = {};
+	const char *filter;
 	int count = 0;
 
-	run_sql(get_row_count, &count,
-		"select count(*) from caller_info where %s;",
-		get_static_filter(sym));
+	filter = bind_static_filter(&bind, sym);
+	run_sql_bound(get_row_count, &count, &bind,
+		"select count(*) from caller_info where %s;", filter);
 	if (count > 5000)
 		return true;
 	return false;
@@ -791,27 +1281,30 @@ static bool too_much_caller_info_data(struct symbol *sym)
 static void sql_select_caller_info(struct select_caller_info_data *data,
 	const char *cols, struct symbol *sym)
 {
+	struct sql_bind bind = {};
+	const char *filter;
+
 	if (__inline_fn) {
-		mem_sql(caller_info_callback, data,
-			"select %s from caller_info where call_id = %lu;",
-			cols, (unsigned long)__inline_fn);
+		inline_summary_select_callers((unsigned long)__inline_fn,
+					      caller_info_callback, data);
 		return;
 	}
 
 	if (is_common_function(sym->ident->name))
 		return;
-	run_sql(caller_info_callback, data,
+	filter = bind_static_filter(&bind, sym);
+	run_sql_bound(caller_info_callback, data, &bind,
 		"select %s from common_caller_info where %s order by call_id;",
-		cols, get_static_filter(sym));
+		cols, filter);
 	if (data->results)
 		return;
 
 	if (too_much_caller_info_data(sym))
 		return;
 
-	run_sql(caller_info_callback, data,
+	run_sql_bound(caller_info_callback, data, &bind,
 		"select %s from caller_info where %s order by call_id;",
-		cols, get_static_filter(sym));
+		cols, filter);
 }
 
 void select_caller_info_hook(void (*callback)(const char *name, struct symbol *sym, char *key, char *value), int type)
@@ -949,7 +1442,9 @@ static void clear_cached_return_vals(void)
 struct range_list *db_return_vals(struct expression *expr)
 {
 	struct return_info ret_info = {};
+	struct sql_bind bind = {};
 	struct sm_state *sm;
+	const char *filter;
 
 	if (!expr)
 		return NULL;
@@ -978,13 +1473,13 @@ struct range_list *db_return_vals(struct expression *expr)
 
 	ret_info.return_range_list = NULL;
 	if (inlinable(expr->fn)) {
-		mem_sql(db_return_callback, &ret_info,
-			"select distinct return from return_states where call_id = '%lu';",
-			(unsigned long)expr);
+		inline_summary_select_return_ranges((unsigned long)expr,
+						    db_return_callback, &ret_info);
 	} else {
-		run_sql(db_return_callback, &ret_info,
+		filter = bind_static_filter(&bind, expr->fn->symbol);
+		run_sql_bound(db_return_callback, &ret_info, &bind,
 			"select distinct return from return_states where %s;",
-			get_static_filter(expr->fn->symbol));
+			filter);
 	}
 	cached_rl = clone_rl(ret_info.return_range_list);
 	return ret_info.return_range_list;
@@ -993,6 +1488,7 @@ struct range_list *db_return_vals(struct expression *expr)
 struct range_list *db_return_vals_from_str(const char *fn_name)
 {
 	struct return_info ret_info;
+	struct sql_bind bind = {};
 
 	if (!fn_name)
 		return NULL;
@@ -1005,9 +1501,9 @@ struct range_list *db_return_vals_from_str(const char *fn_name)
 	ret_info.return_type = &llong_ctype;
 	ret_info.return_range_list = NULL;
 
-	run_sql(db_return_callback, &ret_info,
-		"select distinct return from return_states where function = '%s';",
-		fn_name);
+	sql_bind_text(&bind, fn_name);
+	run_sql_bound(db_return_callback, &ret_info, &bind,
+		"select distinct return from return_states where function = ?;");
 	cached_str_rl = clone_rl(ret_info.return_range_list);
 	return ret_info.return_range_list;
 }
@@ -1022,6 +1518,8 @@ struct range_list *db_return_vals_from_str(const char *fn_name)
 struct range_list *db_return_vals_no_args(struct expression *expr)
 {
 	struct return_info ret_info = {};
+	struct sql_bind bind = {};
+	const char *filter;
 
 	if (!expr || expr->type != EXPR_SYMBOL)
 		return NULL;
@@ -1037,9 +1535,10 @@ struct range_list *db_return_vals_no_args(struct expression *expr)
 	if (!ret_info.return_type)
 		return NULL;
 
-	run_sql(db_return_callback, &ret_info,
+	filter = bind_static_filter(&bind, expr->symbol);
+	run_sql_bound(db_return_callback, &ret_info, &bind,
 		"select distinct return from return_states where %s;",
-		get_static_filter(expr->symbol));
+		filter);
 
 	cached_no_args_rl = clone_rl(ret_info.return_range_list);
 	return ret_info.return_range_list;
@@ -1495,10 +1994,12 @@ static void match_data_from_db(struct symbol *sym)
 		data.results = 0;
 
 		FOR_EACH_PTR(ptr_names, ptr) {
-			run_sql(caller_info_callback, &data,
+			struct sql_bind bind = {};
+
+			sql_bind_text(&bind, ptr);
+			run_sql_bound(caller_info_callback, &data, &bind,
 				"select call_id, type, parameter, key, value"
-				" from common_caller_info where function = '%s' order by call_id",
-				ptr);
+				" from common_caller_info where function = ? order by call_id");
 		} END_FOR_EACH_PTR(ptr);
 
 		if (data.results) {
@@ -1509,10 +2010,12 @@ static void match_data_from_db(struct symbol *sym)
 		}
 
 		FOR_EACH_PTR(ptr_names, ptr) {
-			run_sql(caller_info_callback, &data,
+			struct sql_bind bind = {};
+
+			sql_bind_text(&bind, ptr);
+			run_sql_bound(caller_info_callback, &data, &bind,
 				"select call_id, type, parameter, key, value"
-				" from caller_info where function = '%s' order by call_id",
-				ptr);
+				" from caller_info where function = ? order by call_id");
 			free_string(ptr);
 		} END_FOR_EACH_PTR(ptr);
 
@@ -1991,7 +2494,7 @@ static int ptr_in_list(struct sm_state *sm, struct state_list *slist)
 	struct sm_state *tmp;
 
 	FOR_EACH_PTR(slist, tmp) {
-		if (strcmp(tmp->state->name, sm->state->name) == 0)
+		if (strcmp(show_state(tmp->state), show_state(sm->state)) == 0)
 			return 1;
 	} END_FOR_EACH_PTR(tmp);
 
@@ -2575,7 +3078,7 @@ impossible:
 	FOR_EACH_PTR(sm->possible, tmp) {
 		if (!is_leaf(tmp))
 			continue;
-		if (strcmp(tmp->state->name, "impossible") != 0)
+		if (strcmp(show_state(tmp->state), "impossible") != 0)
 			continue;
 		call_hooks_based_on_pool(expr, sm, tmp);
 		return true;
@@ -2773,14 +3276,6 @@ static void print_return_info(int return_id, char *return_ranges, struct express
 	} END_FOR_EACH_PTR(cb);
 }
 
-static void reset_memdb(struct symbol *sym)
-{
-	mem_sql(NULL, NULL, "delete from caller_info;");
-	mem_sql(NULL, NULL, "delete from return_states;");
-	mem_sql(NULL, NULL, "delete from call_implies;");
-	mem_sql(NULL, NULL, "delete from return_implies;");
-}
-
 static void match_end_func_info(struct symbol *sym)
 {
 	if (__path_is_null())
@@ -2792,53 +3287,19 @@ static void match_after_func(struct symbol *sym)
 {
 	clear_cached_return_vals();
 	if (!__inline_fn)
-		reset_memdb(sym);
+		clear_inline_summaries();
 }
 
-static void init_memdb(void)
+static void load_schema_files(struct sqlite3 *db, const char **schema_files, int nr)
 {
-	char *err = NULL;
-	int rc;
-	const char *schema_files[] = {
-		"db/db.schema",
-		"db/caller_info.schema",
-		"db/common_caller_info.schema",
-		"db/return_states.schema",
-		"db/function_type_size.schema",
-		"db/type_size.schema",
-		"db/function_type_info.schema",
-		"db/type_info.schema",
-		"db/call_implies.schema",
-		"db/return_implies.schema",
-		"db/function_ptr.schema",
-		"db/local_values.schema",
-		"db/function_type_value.schema",
-		"db/type_value.schema",
-		"db/function_type.schema",
-		"db/data_info.schema",
-		"db/parameter_name.schema",
-		"db/constraints.schema",
-		"db/constraints_required.schema",
-		"db/fn_ptr_data_link.schema",
-		"db/fn_data_link.schema",
-		"db/mtag_about.schema",
-		"db/mtag_info.schema",
-		"db/mtag_map.schema",
-		"db/mtag_data.schema",
-		"db/mtag_alias.schema",
-	};
 	static char buf[4096];
+	char *err = NULL;
 	int fd;
 	int ret;
+	int rc;
 	int i;
 
-	rc = sqlite3_open(":memory:", &mem_db);
-	if (rc != SQLITE_OK) {
-		sm_ierror("starting In-Memory database.");
-		return;
-	}
-
-	for (i = 0; i < ARRAY_SIZE(schema_files); i++) {
+	for (i = 0; i < nr; i++) {
 		fd = open_schema_file(schema_files[i]);
 		if (fd < 0)
 			continue;
@@ -2854,7 +3315,7 @@ static void init_memdb(void)
 			continue;
 		}
 		buf[ret] = '\0';
-		rc = sqlite3_exec(mem_db, buf, NULL, NULL, &err);
+		rc = sqlite3_exec(db, buf, NULL, NULL, &err);
 		if (rc != SQLITE_OK) {
 			sm_ierror("SQL error #2: %s", err);
 			sm_ierror("%s", buf);
@@ -2862,9 +3323,24 @@ static void init_memdb(void)
 	}
 }
 
+static void init_memdb(void)
+{
+	int rc;
+	const char *schema_files[] = {
+		"db/mtag_data.schema",
+	};
+
+	rc = sqlite3_open(":memory:", &mem_db);
+	if (rc != SQLITE_OK) {
+		sm_ierror("starting In-Memory database.");
+		return;
+	}
+
+	load_schema_files(mem_db, schema_files, ARRAY_SIZE(schema_files));
+}
+
 static void init_cachedb(void)
 {
-	char *err = NULL;
 	int rc;
 	const char *schema_files[] = {
 		"db/call_implies.schema",
@@ -2876,10 +3352,6 @@ static void init_cachedb(void)
 		"db/sink_info.schema",
 		"db/hash_string.schema",
 	};
-	static char buf[4096];
-	int fd;
-	int ret;
-	int i;
 
 	rc = sqlite3_open(":memory:", &cache_db);
 	if (rc != SQLITE_OK) {
@@ -2887,28 +3359,165 @@ static void init_cachedb(void)
 		return;
 	}
 
-	for (i = 0; i < ARRAY_SIZE(schema_files); i++) {
-		fd = open_schema_file(schema_files[i]);
-		if (fd < 0)
-			continue;
-		ret = read(fd, buf, sizeof(buf));
-		if (ret < 0) {
-			sm_ierror("failed to read: %s", schema_files[i]);
-			continue;
-		}
-		close(fd);
-		if (ret == sizeof(buf)) {
-			sm_ierror("Schema file too large:  %s (limit %zd bytes)",
-			       schema_files[i], sizeof(buf));
-			continue;
-		}
-		buf[ret] = '\0';
-		rc = sqlite3_exec(cache_db, buf, NULL, NULL, &err);
-		if (rc != SQLITE_OK) {
-			sm_ierror("SQL error #2: %s", err);
-			sm_ierror("%s", buf);
-		}
+	load_schema_files(cache_db, schema_files, ARRAY_SIZE(schema_files));
+}
+
+/*
+ * With --info-shard=<dir> the "SQL:" inserts are done directly on a per
+ * process SQLite file in <dir> instead of being printed.  The shards have
+ * the same tables as smatch_db.sqlite and smatch_data/db/sm_merge_shards
+ * loads them into the real DB in one transaction.  The "SQL_late:"
+ * statements are stored as text in the late_sql table because they have
+ * to be run after all the shards are loaded.
+ */
+struct sqlite3 *shard_db;
+
+void open_info_shard(const char *dir)
+{
+	const char *schema_files[] = {
+		"db/caller_info.schema",
+		"db/common_caller_info.schema",
+		"db/return_states.schema",
+		"db/function_type_size.schema",
+		"db/type_size.schema",
+		"db/function_type_info.schema",
+		"db/type_info.schema",
+		"db/call_implies.schema",
+		"db/return_implies.schema",
+		"db/function_ptr.schema",
+		"db/local_values.schema",
+		"db/function_type_value.schema",
+		"db/type_value.schema",
+		"db/function_type.schema",
+		"db/data_info.schema",
+		"db/parameter_name.schema",
+		"db/constraints.schema",
+		"db/constraints_required.schema",
+		"db/fn_ptr_data_link.schema",
+		"db/fn_data_link.schema",
+		"db/mtag_about.schema",
+		"db/mtag_info.schema",
+		"db/mtag_map.schema",
+		"db/mtag_data.schema",
+		"db/mtag_alias.schema",
+		"db/param_map.schema",
+		"db/sink_info.schema",
+		"db/hash_string.schema",
+	};
+	char filename[PATH_MAX];
+	char *err = NULL;
+	int fd, i;
+	int rc;
+
+	if (!dir || !option_info)
+		return;
+
+	/*
+	 * PIDs get reused during a kernel build so never overwrite an
+	 * existing shard.  Create the file exclusively and let SQLite set
+	 * up the empty file.
+	 */
+	for (i = 0; i < 1000; i++) {
+		snprintf(filename, sizeof(filename), "%s/shard.%d.%d.sqlite",
+			 dir, getpid(), i);
+		fd = open(filename, O_WRONLY | O_CREAT | O_EXCL, 0644);
+		if (fd >= 0 || errno != EEXIST)
+			break;
+	}
+	if (fd < 0)
+		sm_fatal("Cannot create %s: %s", filename, strerror(errno));
+	close(fd);
+
+	rc = sqlite3_open(filename, &shard_db);
+	if (rc != SQLITE_OK)
+		sm_fatal("Cannot open %s", filename);
+
+	load_schema_files(shard_db, schema_files, ARRAY_SIZE(schema_files));
+	rc = sqlite3_exec(shard_db,
+			  "PRAGMA journal_mode = OFF;"
+			  "PRAGMA synchronous = OFF;"
+			  "create table late_sql (stmt text);"
+			  "begin transaction;",
+			  NULL, NULL, &err);
+	if (rc != SQLITE_OK)
+		sm_fatal("%s: %s", filename, err);
+}
+
+void close_info_shard(void)
+{
+	char *err = NULL;
+
+	if (!shard_db)
+		return;
+
+	if (sqlite3_exec(shard_db, "commit;", NULL, NULL, &err) != SQLITE_OK)
+		sm_ierror("SQL error #2: %s", err);
+	sqlite3_close(shard_db);
+	shard_db = NULL;
+}
+
+static char *vformat(const char *fmt, va_list args)
+{
+	va_list copy;
+	char *buf;
+	int len;
+
+	va_copy(copy, args);
+	len = vsnprintf(NULL, 0, fmt, copy);
+	va_end(copy);
+
+	buf = malloc(len + 1);
+	if (!buf)
+		sm_fatal("%s: out of memory", __func__);
+	vsnprintf(buf, len + 1, fmt, args);
+	return buf;
+}
+
+static void exec_shard(int late, const char *sql)
+{
+	char *err = NULL;
+	char *stmt = NULL;
+	int rc;
+
+	if (late) {
+		stmt = sqlite3_mprintf("insert into late_sql values ('%q');", sql);
+		rc = sqlite3_exec(shard_db, stmt, NULL, NULL, &err);
+	} else {
+		rc = sqlite3_exec(shard_db, sql, NULL, NULL, &err);
+	}
+	if (rc != SQLITE_OK) {
+		sm_ierror("SQL error #2: %s", err);
+		sm_ierror("SQL: '%s'", sql);
+		sqlite3_free(err);
 	}
+	sqlite3_free(stmt);
+}
+
+void sql_save_shard(int late, const char *fmt, ...)
+{
+	va_list args;
+	char *sql;
+
+	va_start(args, fmt);
+	sql = vformat(fmt, args);
+	va_end(args);
+
+	exec_shard(late, sql);
+	free(sql);
+}
+
+void sql_insert_shard(const char *table, int ignore, int late, const char *fmt, ...)
+{
+	va_list args;
+	char *values;
+
+	va_start(args, fmt);
+	values = vformat(fmt, args);
+	va_end(args);
+
+	sql_save_shard(late, "insert %sinto %s values(%s);",
+		       ignore ? "or ignore " : "", table, values);
+	free(values);
 }
 
 static int save_cache_data(void *_table, int argc, char **argv, char **azColName)
@@ -2932,6 +3541,10 @@ static int save_cache_data(void *_table, int argc, char **argv, char **azColName
 	if (p - buf > 4096)
 		return 0;
 
+	if (shard_db) {
+		sql_save_shard(0, "%s", buf);
+		return 0;
+	}
 	sm_msg("SQL: %s", buf);
 	return 0;
 }
@@ -2954,6 +3567,38 @@ static void dump_cache(struct symbol_list *sym_list)
 	}
 }
 
+/*
+ * The DB format is saved in "PRAGMA user_version" by create_db.sh.  v2
+ * changed the hash used for the file ids and the mtags (see smatch_hash.c).
+ */
+#define SMATCH_DB_FORMAT 2
+
+static int get_int_callback(void *_val, int argc, char **argv, char **azColName)
+{
+	int *val = _val;
+
+	if (argc == 1 && argv[0])
+		*val = atoi(argv[0]);
+	return 0;
+}
+
+static void check_db_format(const char *db_file)
+{
+	int version = -1;
+	int tables = 0;
+
+	run_sql(get_int_callback, &version, "PRAGMA user_version;");
+	if (version >= SMATCH_DB_FORMAT)
+		return;
+	run_sql(get_int_callback, &tables,
+		"select count(*) from sqlite_master where type = 'table';");
+	if (!tables)
+		return;
+	fprintf(stderr, "smatch: '%s' uses DB format %d instead of %d.  "
+		"Run smatch_data/db/rekey_hashes.py or rebuild it.\n",
+		db_file, version, SMATCH_DB_FORMAT);
+}
+
 void open_smatch_db(char *db_file)
 {
 	int rc;
@@ -2974,9 +3619,53 @@ void open_smatch_db(char *db_file)
 	}
 	run_sql(NULL, NULL,
 		"PRAGMA cache_size = %d;", SQLITE_CACHE_PAGES);
+	check_db_format(db_file);
 	return;
 }
 
+static void finalize_db_stmts(struct sqlite3 *db)
+{
+	struct db_stmt **p, *tmp;
+	int i;
+
+	for (i = 0; i < DB_STMT_HASH; i++) {
+		p = &db_stmt_hash[i];
+		while ((tmp = *p)) {
+			if (tmp->db != db) {
+				p = &tmp->next;
+				continue;
+			}
+			*p = tmp->next;
+			sqlite3_finalize(tmp->stmt);
+			free_string(tmp->sql);
+			free(tmp);
+		}
+	}
+}
+
+/*
+ * A SQLite connection can't be used on both sides of a fork() so the fork
+ * server workers open smatch_db again.  The in memory DBs are private to
+ * each process so they are fine.
+ */
+void reopen_smatch_db(char *db_file)
+{
+	int rc;
+
+	if (option_no_db)
+		return;
+
+	finalize_db_stmts(smatch_db);
+	sqlite3_close(smatch_db);
+	smatch_db = NULL;
+
+	rc = sqlite3_open_v2(db_file, &smatch_db, SQLITE_OPEN_READONLY, NULL);
+	if (rc != SQLITE_OK)
+		sm_fatal("Cannot open %s", db_file);
+	run_sql(NULL, NULL,
+		"PRAGMA cache_size = %d;", SQLITE_CACHE_PAGES);
+}
+
 static char *get_next_string(char **str)
 {
 	static char string[256];
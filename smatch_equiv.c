@@ -166,6 +166,8 @@ void remove_from_equiv(const char *name, struct symbol *sym)
 			continue;
 
 		new_sm = clone_sm(old_sm);
+		if (get_dinfo(new_sm->state)->interned)
+			new_sm->state = copy_estate(old_sm->state);
 		get_dinfo(new_sm->state)->related = to_update;
 		__set_sm(new_sm);
 	} END_FOR_EACH_PTR(rel);
@@ -214,7 +216,7 @@ void set_equiv(struct expression *left, struct expression *right)
 
 	/* This block is because we want to preserve the implications. */
 	left_sm = clone_sm(right_sm);
-	left_sm->name = alloc_string(left_name);
+	left_sm->name = intern_sname(left_name);
 	left_sm->sym = left_sym;
 	left_sm->state = clone_estate_cast(get_type(left), right_sm->state);
 	/* FIXME: The expression we're passing is wrong */
@@ -223,7 +225,7 @@ void set_equiv(struct expression *left, struct expression *right)
 
 	if (other_name && other_sym) {
 		other_sm = clone_sm(right_sm);
-		other_sm->name = alloc_string(other_name);
+		other_sm->name = intern_sname(other_name);
 		other_sm->sym = other_sym;
 		other_sm->state = clone_estate_cast(get_type(left), left_sm->state);
 		set_extra_mod_helper(other_name, other_sym, NULL, other_sm->state);
@@ -30,9 +30,87 @@
 #include "smatch_slist.h"
 #include "smatch_extra.h"
 
+static int rlists_equiv(struct related_list *one, struct related_list *two);
+
+static unsigned int hash_estate(struct smatch_state *state)
+{
+	struct data_info *dinfo = get_dinfo(state);
+	struct data_range *drange;
+	struct relation *rel;
+	unsigned int hash;
+
+	hash = dinfo->hard_max | dinfo->capped << 1 | dinfo->treat_untagged << 2 |
+	       dinfo->assigned << 3 | dinfo->set << 4;
+	FOR_EACH_PTR(dinfo->value_ranges, drange) {
+		hash = hash_mix(hash, (unsigned long)drange->min.type);
+		hash = hash_mix(hash, drange->min.uvalue);
+		hash = hash_mix(hash, drange->max.uvalue);
+	} END_FOR_EACH_PTR(drange);
+	FOR_EACH_PTR(dinfo->related, rel) {
+		hash = hash_mix(hash, (unsigned long)rel->sym);
+	} END_FOR_EACH_PTR(rel);
+	hash = hash_mix(hash, dinfo->fuzzy_max.uvalue);
+	return hash;
+}
+
+static bool same_sval(sval_t one, sval_t two)
+{
+	/* -0.0 and 0.0 are equal but they don't print the same */
+	if (sval_is_fp(one) || sval_is_fp(two))
+		return false;
+	return one.type == two.type && one.uvalue == two.uvalue;
+}
+
+static bool same_rl(struct range_list *one, struct range_list *two)
+{
+	struct data_range *one_range, *two_range;
+
+	PREPARE_PTR_LIST(one, one_range);
+	PREPARE_PTR_LIST(two, two_range);
+	for (;;) {
+		if (!one_range || !two_range)
+			return one_range == two_range;
+		if (one_range != two_range &&
+		    (!same_sval(one_range->min, two_range->min) ||
+		     !same_sval(one_range->max, two_range->max)))
+			return false;
+		NEXT_PTR_LIST(one_range);
+		NEXT_PTR_LIST(two_range);
+	}
+	FINISH_PTR_LIST(two_range);
+	FINISH_PTR_LIST(one_range);
+
+	return true;
+}
+
+/*
+ * estates_equiv() ignores some of the fields.  The interned states have to
+ * be exactly the same.
+ */
+static bool same_estate(struct smatch_state *one, struct smatch_state *two)
+{
+	struct data_info *a = get_dinfo(one);
+	struct data_info *b = get_dinfo(two);
+
+	if (a->hard_max != b->hard_max || a->capped != b->capped ||
+	    a->treat_untagged != b->treat_untagged ||
+	    a->assigned != b->assigned || a->set != b->set)
+		return false;
+	if (a->fuzzy_max.type != b->fuzzy_max.type ||
+	    (a->fuzzy_max.type && !same_sval(a->fuzzy_max, b->fuzzy_max)))
+		return false;
+	if (!same_rl(a->value_ranges, b->value_ranges))
+		return false;
+	return rlists_equiv(a->related, b->related);
+}
+
+/*
+ * The merged estates are interned so they must not be changed afterwards.
+ * Use copy_estate() if they have to be.
+ */
 struct smatch_state *merge_estates(struct smatch_state *s1, struct smatch_state *s2)
 {
-	struct smatch_state *tmp;
+	struct smatch_state *ret, *tmp;
 	struct range_list *value_ranges;
 	struct related_list *rlist;
 	bool capped = false;
@@ -71,7 +149,15 @@ struct smatch_state *merge_estates(struct smatch_state *s1, struct smatch_state
 	if (estate_new(s1) || estate_new(s2))
 		estate_set_new(tmp);
 
-	return tmp;
+	/*
+	 * The related lists are sometimes updated in place so only the
+	 * estates without one are shared.
+	 */
+	if (estate_related(tmp))
+		return tmp;
+	ret = intern_state(SMATCH_EXTRA, hash_estate(tmp), tmp, same_estate);
+	get_dinfo(ret)->interned = 1;
+	return ret;
 }
 
 struct data_info *get_dinfo(struct smatch_state *state)
@@ -262,6 +348,24 @@ static int rlists_equiv(struct related_list *one, struct related_list *two)
 	return 1;
 }
 
+static const char *render_estate(struct smatch_state *state)
+{
+	return show_rl(estate_rl(state));
+}
+
+/*
+ * Same as comparing the show_state() strings but it doesn't print the names
+ * if they haven't been printed already and the range lists are the same.
+ */
+bool estate_names_equal(struct smatch_state *one, struct smatch_state *two)
+{
+	if (!one->name && !two->name &&
+	    one->render == render_estate && two->render == render_estate &&
+	    same_rl(estate_rl(one), estate_rl(two)))
+		return true;
+	return strcmp(show_state(one), show_state(two)) == 0;
+}
+
 int estates_equiv(struct smatch_state *one, struct smatch_state *two)
 {
 	if (!one || !two)
@@ -278,7 +382,7 @@ int estates_equiv(struct smatch_state *one, struct smatch_state *two)
 		return 0;
 	if (estate_new(one) != estate_new(two))
 		return 0;
-	if (strcmp(one->name, two->name) == 0)
+	if (estate_names_equal(one, two))
 		return 1;
 	return 0;
 }
@@ -366,10 +470,33 @@ struct smatch_state *clone_estate(struct smatch_state *state)
 
 	ret = __alloc_smatch_state(0);
 	ret->name = state->name;
+	ret->render = state->render;
 	ret->data = clone_dinfo(get_dinfo(state));
 	return ret;
 }
 
+/*
+ * clone_estate() resets the flags.  This is an exact copy for when an
+ * interned estate has to be changed.
+ */
+struct smatch_state *copy_estate(struct smatch_state *state)
+{
+	struct smatch_state *ret;
+	struct data_info *dinfo;
+
+	if (!state)
+		return NULL;
+
+	dinfo = alloc_dinfo();
+	*dinfo = *get_dinfo(state);
+	dinfo->interned = 0;
+	ret = __alloc_smatch_state(0);
+	ret->name = state->name;
+	ret->render = state->render;
+	ret->data = dinfo;
+	return ret;
+}
+
 struct smatch_state *clone_partial_estate(struct smatch_state *state, struct range_list *rl)
 {
 	struct smatch_state *ret;
@@ -422,7 +549,7 @@ struct smatch_state *alloc_estate_sval(sval_t sval)
 
 	state = __alloc_smatch_state(0);
 	state->data = alloc_dinfo_range(sval, sval);
-	state->name = show_rl(get_dinfo(state)->value_ranges);
+	state->render = render_estate;
 	estate_set_hard_max(state);
 	estate_set_fuzzy_max(state, sval);
 	return state;
@@ -434,7 +561,7 @@ struct smatch_state *alloc_estate_range(sval_t min, sval_t max)
 
 	state = __alloc_smatch_state(0);
 	state->data = alloc_dinfo_range(min, max);
-	state->name = show_rl(get_dinfo(state)->value_ranges);
+	state->render = render_estate;
 	return state;
 }
 
@@ -447,7 +574,7 @@ struct smatch_state *alloc_estate_rl(struct range_list *rl)
 
 	state = __alloc_smatch_state(0);
 	state->data = alloc_dinfo_range_list(rl);
-	state->name = show_rl(rl);
+	state->render = render_estate;
 	return state;
 }
 
@@ -463,7 +590,7 @@ struct smatch_state *clone_estate_cast(struct symbol *type, struct smatch_state
 	dinfo->value_ranges = clone_rl(cast_rl(type, estate_rl(state)));
 
 	ret = __alloc_smatch_state(0);
-	ret->name = show_rl(dinfo->value_ranges);
+	ret->render = render_estate;
 	ret->data = dinfo;
 
 	return ret;
@@ -2549,7 +2549,7 @@ static bool used_param_value_info(struct expression *call, int param, char *prin
 		return true;
 
 	/* This is basically pointless information */
-	if (strcmp(sm->state->name, "0,4096-ptr_max") == 0)
+	if (strcmp(show_state(sm->state), "0,4096-ptr_max") == 0)
 		return false;
 
 	/*
@@ -2683,10 +2683,10 @@ static void returned_struct_members(int return_id, char *return_ranges, struct e
 		if (!compare_str && !math_str && estate_is_whole(sm->state))
 			continue;
 
-		if (math_str && strcmp(sm->state->name, math_str) != 0)
-			snprintf(val_buf, sizeof(val_buf), "%s[%s]", sm->state->name, math_str);
+		if (math_str && strcmp(show_state(sm->state), math_str) != 0)
+			snprintf(val_buf, sizeof(val_buf), "%s[%s]", show_state(sm->state), math_str);
 		else
-			snprintf(val_buf, sizeof(val_buf), "%s%s", sm->state->name, compare_str ?: "");
+			snprintf(val_buf, sizeof(val_buf), "%s%s", show_state(sm->state), compare_str ?: "");
 
 		sql_insert_return_states(return_id, return_ranges, PARAM_VALUE,
 					 -1, name_buf, val_buf);
@@ -3151,6 +3151,22 @@ static void db_buf_add(struct expression *expr, int param, char *key, char *valu
 	create_recursive_fake_assignments(deref_expression(arg), &db_buf_add_helper, NULL);
 }
 
+/*
+ * These are updated in place.  The interned estates are shared so those have
+ * to be copied first.
+ */
+static struct smatch_state *get_param_state_to_update(const char *name, struct symbol *sym)
+{
+	struct smatch_state *state;
+
+	state = get_state(SMATCH_EXTRA, name, sym);
+	if (state && get_dinfo(state)->interned) {
+		state = copy_estate(state);
+		set_state(SMATCH_EXTRA, name, sym, state);
+	}
+	return state;
+}
+
 static void set_param_fuzzy_max(const char *name, struct symbol *sym, char *key, char *value)
 {
 	struct expression *expr;
@@ -3165,7 +3181,7 @@ static void set_param_fuzzy_max(const char *name, struct symbol *sym, char *key,
 	if (!fullname)
 		return;
 
-	state = get_state(SMATCH_EXTRA, fullname, sym);
+	state = get_param_state_to_update(fullname, sym);
 	if (!state)
 		return;
 	type = estate_type(state);
@@ -3186,7 +3202,7 @@ static void set_param_hard_max(const char *name, struct symbol *sym, char *key,
 	if (!fullname)
 		return;
 
-	state = get_state(SMATCH_EXTRA, fullname, sym);
+	state = get_param_state_to_update(fullname, sym);
 	if (!state)
 		return;
 	estate_set_hard_max(state);
@@ -3250,6 +3266,7 @@ void register_smatch_extra(int id)
 	my_id = id;
 
 	set_dynamic_states(my_id);
+	func_scope_relation_alloc();
 	add_merge_hook(my_id, &merge_estates);
 	add_unmatched_state_hook(my_id, &unmatched_state);
 	select_caller_info_hook(set_param_value, PARAM_VALUE);
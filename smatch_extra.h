@@ -24,6 +24,7 @@ struct relation {
 };
 
 DECLARE_PTR_LIST(related_list, struct relation);
+DECLARE_ALLOCATOR(relation);
 
 struct data_info {
 	struct related_list *related;
@@ -34,6 +35,7 @@ struct data_info {
 	unsigned int treat_untagged:1;
 	unsigned int assigned:1;
 	unsigned int set:1;
+	unsigned int interned:1;
 };
 DECLARE_ALLOCATOR(data_info);
 
@@ -122,6 +124,7 @@ void split_comparison_rl(struct range_list *left_orig, int op, struct range_list
 
 void free_data_info_allocs(void);
 void free_all_rl(void);
+void show_range_stats(void);
 
 /* smatch_estate.c */
 
@@ -131,6 +134,8 @@ struct smatch_state *alloc_estate_range(sval_t min, sval_t max);
 struct smatch_state *alloc_estate_rl(struct range_list *rl);
 struct smatch_state *alloc_estate_whole(struct symbol *type);
 struct smatch_state *clone_estate(struct smatch_state *state);
+struct smatch_state *copy_estate(struct smatch_state *state);
+bool estate_names_equal(struct smatch_state *one, struct smatch_state *two);
 struct smatch_state *clone_estate_cast(struct symbol *type, struct smatch_state *state);
 struct smatch_state *clone_partial_estate(struct smatch_state *state, struct range_list *rl);
 
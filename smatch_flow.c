@@ -68,7 +68,9 @@ static int indent_cnt;
 int __in_pre_condition = 0;
 int __bail_on_rest_of_function = 0;
 static struct timeval fn_start_time;
-static struct timeval outer_fn_start_time;
+unsigned long __fn_work;
+unsigned long __outer_fn_work;
+unsigned long option_work_budget = DEFAULT_WORK_BUDGET;
 char *get_function(void) { return cur_func; }
 int get_lineno(void) { return __smatch_lineno; }
 int inside_loop(void) { return !!loop_count; }
@@ -182,14 +184,34 @@ const char *get_base_file(void)
 	return filtered_name;
 }
 
+struct file_id_cache {
+	char *name;
+	unsigned long long id;
+};
+
+/* the file names are hashed for every row that goes into the DB */
+static unsigned long long cached_file_id(struct file_id_cache *cache, const char *name)
+{
+	if (cache->name && strcmp(cache->name, name) == 0)
+		return cache->id;
+	free(cache->name);
+	cache->name = alloc_string(name);
+	cache->id = str_to_llu_hash(name);
+	return cache->id;
+}
+
 unsigned long long get_file_id(void)
 {
-	return str_to_llu_hash(get_filename());
+	static struct file_id_cache cache;
+
+	return cached_file_id(&cache, get_filename());
 }
 
 unsigned long long get_base_file_id(void)
 {
-	return str_to_llu_hash(get_base_file());
+	static struct file_id_cache cache;
+
+	return cached_file_id(&cache, get_base_file());
 }
 
 static void set_position(struct position pos)
@@ -341,7 +363,7 @@ static int get_func_time(struct symbol *sym)
 	unsigned long time = 0;
 
 	run_sql(&save_func_time, &time,
-		"select key from return_implies where %s and type = %d;",
+		"select value from return_implies where %s and type = %d;",
 		get_static_filter(sym), FUNC_TIME);
 
 	return time;
@@ -1348,14 +1370,19 @@ next:
 	__split_stmt(stmt->case_statement);
 }
 
-int time_parsing_function(void)
+/*
+ * The function budgets are counted in units of work (sm_states looked at
+ * while doing implications, merges) instead of in seconds so that the
+ * results don't depend on how busy the machine is.
+ */
+unsigned long work_parsing_function(void)
 {
-	return ms_since(&fn_start_time) / 1000;
+	return __fn_work;
 }
 
 bool taking_too_long(void)
 {
-	if ((ms_since(&outer_fn_start_time) / 1000) > 60 * 5) /* five minutes */
+	if (__outer_fn_work > option_work_budget * 5)
 		return 1;
 	return 0;
 }
@@ -2311,15 +2338,66 @@ static void record_func_time(void)
 	}
 }
 
+static void record_merge_stats(void)
+{
+	if (!option_time)
+		return;
+	if (!__merge_reused_cnt && !__merge_merged_cnt)
+		return;
+
+	final_pass++;
+	sm_msg("merge_stats: reused %lu merged %lu",
+	       __merge_reused_cnt, __merge_merged_cnt);
+	final_pass--;
+}
+
+static void record_func_mem(unsigned long start, unsigned long peak)
+{
+	unsigned long end = get_mem_used();
+
+	if (!option_mem)
+		return;
+
+	final_pass++;
+	sm_msg("mem: func peak=%luKb retained=%ldKb",
+	       (peak - start) / 1024, ((long)end - (long)start) / 1024);
+	final_pass--;
+}
+
+static void record_func_work(void)
+{
+	if (!option_time)
+		return;
+
+	final_pass++;
+	sm_msg("func_work: %lu budget %lu", __outer_fn_work, option_work_budget);
+	final_pass--;
+}
+
+static void record_expr_cache(void)
+{
+	if (option_time) {
+		final_pass++;
+		sm_msg("expr_cache: name hits %lu misses %lu value hits %lu misses %lu",
+		       expr_str_cache_hits, expr_str_cache_misses,
+		       value_cache_hits, value_cache_misses);
+		final_pass--;
+	}
+	expr_str_cache_hits = expr_str_cache_misses = 0;
+	value_cache_hits = value_cache_misses = 0;
+}
+
 static void split_function(struct symbol *sym)
 {
 	struct symbol *base_type = get_base_type(sym);
+	unsigned long mem_start, mem_peak;
 
 	if (!base_type->stmt && !base_type->inline_stmt)
 		return;
 
-	gettimeofday(&outer_fn_start_time, NULL);
 	gettimeofday(&fn_start_time, NULL);
+	__fn_work = 0;
+	__outer_fn_work = 0;
 	cur_func_sym = sym;
 	if (sym->ident)
 		cur_func = sym->ident->name;
@@ -2328,10 +2406,14 @@ static void split_function(struct symbol *sym)
 		return;
 	set_position(sym->pos);
 	clear_function_data();
+	reset_func_mem_peak();
+	mem_start = get_mem_used();
 	loop_count = 0;
 	last_goto_statement_handled = 0;
 	sm_debug("new function:  %s\n", cur_func);
 	__stree_id = 0;
+	__merge_reused_cnt = 0;
+	__merge_merged_cnt = 0;
 	if (option_two_passes) {
 		__unnullify_path();
 		loop_num = 0;
@@ -2360,13 +2442,19 @@ static void split_function(struct symbol *sym)
 	__pass_to_client(sym, AFTER_FUNC_HOOK);
 	sym->parsed = true;
 
+	mem_peak = get_func_mem_peak();
 	clear_all_states();
+	free_data_info_allocs();
+	drop_func_scope_allocations();
 
 	record_func_time();
+	record_merge_stats();
+	record_func_work();
+	record_expr_cache();
+	record_func_mem(mem_start, mem_peak);
 
 	cur_func_sym = NULL;
 	cur_func = NULL;
-	free_data_info_allocs();
 	free_expression_stack(&switch_expr_stack);
 	__free_ptr_list((struct ptr_list **)&big_statement_stack);
 	__bail_on_rest_of_function = 0;
@@ -2436,6 +2524,7 @@ void parse_inline(struct expression *call)
 	struct symbol *base_type;
 	char *cur_func_bak = cur_func;  /* not aligned correctly for backup */
 	struct timeval time_backup = fn_start_time;
+	unsigned long work_backup = __fn_work;
 	struct expression *orig_inline = __inline_fn;
 	int orig_budget;
 
@@ -2448,6 +2537,7 @@ void parse_inline(struct expression *call)
 	save_flow_state();
 
 	gettimeofday(&fn_start_time, NULL);
+	__fn_work = 0;
 	__pass_to_client(call, INLINE_FN_START);
 	final_pass = 0;  /* don't print anything */
 	__inline_fn = call;
@@ -2497,6 +2587,7 @@ void parse_inline(struct expression *call)
 
 	restore_flow_state();
 	fn_start_time = time_backup;
+	__fn_work += work_backup;
 	cur_func = cur_func_bak;
 
 	restore_all_states();
@@ -2512,6 +2603,11 @@ static void add_inline_function(struct symbol *sym)
 	static struct symbol_list *already_added;
 	struct symbol *tmp;
 
+	if (in_function_job_worker()) {
+		function_job_add_inline(sym);
+		return;
+	}
+
 	FOR_EACH_PTR(already_added, tmp) {
 		if (tmp == sym)
 			return;
@@ -2624,6 +2720,29 @@ static struct stree *clone_estates_perm(struct stree *orig)
 	return ret;
 }
 
+static bool is_file_function(struct symbol *sym)
+{
+	if (!interesting_function(sym))
+		return false;
+	return sym->type == SYM_NODE && get_base_type(sym)->type == SYM_FN;
+}
+
+static void start_file_function_jobs(struct symbol_list *sym_list)
+{
+	struct symbol_list *fns = NULL;
+	struct symbol *sym;
+
+	if (option_function_jobs < 2)
+		return;
+
+	FOR_EACH_PTR(sym_list, sym) {
+		if (is_file_function(sym))
+			add_ptr_list(&fns, sym);
+	} END_FOR_EACH_PTR(sym);
+	start_function_jobs(fns, &split_function, &add_inline_function);
+	free_ptr_list(&fns);
+}
+
 struct position last_pos;
 static void split_c_file_functions(struct symbol_list *sym_list)
 {
@@ -2641,17 +2760,20 @@ static void split_c_file_functions(struct symbol_list *sym_list)
 	global_states = clone_estates_perm(get_all_states_stree(SMATCH_EXTRA));
 	nullify_path();
 
+	start_file_function_jobs(sym_list);
 	FOR_EACH_PTR(sym_list, sym) {
 		set_position(sym->pos);
 		last_pos = sym->pos;
 		if (!interesting_function(sym))
 			continue;
 		if (sym->type == SYM_NODE && get_base_type(sym)->type == SYM_FN) {
-			split_function(sym);
+			if (!finish_function_job(sym))
+				split_function(sym);
 			process_inlines();
 		}
 		last_pos = sym->pos;
 	} END_FOR_EACH_PTR(sym);
+	end_function_jobs();
 	split_inlines(sym_list);
 	__pass_to_client(sym_list, END_FILE_HOOK);
 }
@@ -2682,6 +2804,7 @@ static void open_output_files(char *base_file)
 	sm_outfd = fopen(buf, "w");
 	if (!sm_outfd)
 		sm_fatal("Cannot open %s", buf);
+	sm_json_setup_stream(sm_outfd);
 
 	if (!option_info)
 		return;
@@ -2729,6 +2852,14 @@ void smatch(struct string_list *filelist)
 	final_pass = 1;
 	if (option_time)
 		sm_msg("time: %lu", stop.tv_sec - start.tv_sec);
-	if (option_mem)
+	if (option_mem) {
 		sm_msg("mem: %luKb", get_max_memory());
+		show_sname_stats();
+		show_range_stats();
+		show_intern_state_stats();
+	}
+	if (option_db_stats)
+		show_db_stats();
+	show_check_profile();
+	close_info_shard();
 }
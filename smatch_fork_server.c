@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2026 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * Opening the DB, loading the smatch_data/ files and registering all the
+ * checks is the same for every file so the fork server does it once and
+ * then forks a fresh process for each file.
+ *
+ *   smatch --fork-server=/tmp/smatch.sock -p=kernel --file-output -m64 &
+ *   make CHECK="smatch --connect=/tmp/smatch.sock" C=1
+ *
+ * The smatch options and the target options (-m64 etc) are taken from the
+ * server command line and it's an error to pass smatch options other than
+ * --connect to the client.  The client only sends its current directory,
+ * the rest of its arguments and its stdin, stdout and stderr.  Each connection
+ * is handled by a process which forks the worker, waits for it and sends
+ * the exit status back to the client.  The worker returns from
+ * run_fork_server() to carry on in main() as if it had been started with
+ * the client's arguments.  It opens its own connection to smatch_db but the
+ * smatch_data/ files are only loaded once, by the server.
+ *
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "smatch.h"
+
+char *option_fork_server;
+char *option_connect;
+
+static void fill_addr(struct sockaddr_un *addr, const char *path)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr->sun_path))
+		sm_fatal("socket path too long: '%s'", path);
+	strcpy(addr->sun_path, path);
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	ssize_t ret;
+
+	while (len) {
+		ret = write(fd, p, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return -1;
+		p += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+static int read_all(int fd, void *buf, size_t len)
+{
+	char *p = buf;
+	ssize_t ret;
+
+	while (len) {
+		ret = read(fd, p, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return -1;
+		p += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+/*
+ * The request is a uint32_t length with the client's stdin, stdout and
+ * stderr attached, followed by the current directory and the arguments as
+ * NUL terminated strings.
+ */
+static int send_request(int sock, const char *buf, uint32_t len)
+{
+	char control[CMSG_SPACE(3 * sizeof(int))] = {};
+	int fds[3] = { 0, 1, 2 };
+	struct msghdr msg = {};
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+
+	iov.iov_base = &len;
+	iov.iov_len = sizeof(len);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	if (sendmsg(sock, &msg, 0) != sizeof(len))
+		return -1;
+	return write_all(sock, buf, len);
+}
+
+static char *recv_request(int sock, int *fds, uint32_t *lenp)
+{
+	char control[CMSG_SPACE(3 * sizeof(int))] = {};
+	struct msghdr msg = {};
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+	uint32_t len;
+	char *buf;
+
+	iov.iov_base = &len;
+	iov.iov_len = sizeof(len);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	if (recvmsg(sock, &msg, 0) != sizeof(len))
+		return NULL;
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+		return NULL;
+	memcpy(fds, CMSG_DATA(cmsg), 3 * sizeof(int));
+
+	buf = malloc(len + 1);
+	if (!buf || read_all(sock, buf, len))
+		return NULL;
+	buf[len] = '\0';
+	*lenp = len;
+	return buf;
+}
+
+int fork_server_client(const char *path, int argc, char **argv)
+{
+	struct sockaddr_un addr;
+	char cwd[PATH_MAX];
+	uint32_t len, pos;
+	int32_t status;
+	char *buf;
+	int sock;
+	int i;
+
+	if (!getcwd(cwd, sizeof(cwd)))
+		sm_fatal("getcwd: %s", strerror(errno));
+
+	len = strlen(cwd) + 1;
+	for (i = 1; i < argc; i++)
+		len += strlen(argv[i]) + 1;
+	buf = malloc(len);
+	if (!buf)
+		sm_fatal("%s: out of memory", __func__);
+	pos = strlen(cwd) + 1;
+	memcpy(buf, cwd, pos);
+	for (i = 1; i < argc; i++) {
+		memcpy(buf + pos, argv[i], strlen(argv[i]) + 1);
+		pos += strlen(argv[i]) + 1;
+	}
+
+	fill_addr(&addr, path);
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)))
+		sm_fatal("cannot connect to '%s': %s", path, strerror(errno));
+	if (send_request(sock, buf, len))
+		sm_fatal("sending to '%s': %s", path, strerror(errno));
+	free(buf);
+
+	if (read_all(sock, &status, sizeof(status))) {
+		fprintf(stderr, "smatch: lost the connection to '%s'\n", path);
+		return 1;
+	}
+	close(sock);
+	return status;
+}
+
+static void handle_connection(int conn, int *argcp, char ***argvp)
+{
+	int32_t status;
+	int fds[3];
+	uint32_t len, pos;
+	char *buf, *cwd;
+	char **argv;
+	int argc;
+	int wstatus;
+	pid_t pid;
+	int i;
+
+	signal(SIGCHLD, SIG_DFL);
+
+	buf = recv_request(conn, fds, &len);
+	if (!buf)
+		exit(1);
+
+	pid = fork();
+	if (pid < 0)
+		exit(1);
+	if (pid == 0) {
+		for (i = 0; i < 3; i++) {
+			dup2(fds[i], i);
+			close(fds[i]);
+		}
+		close(conn);
+
+		cwd = buf;
+		if (chdir(cwd))
+			sm_fatal("chdir '%s': %s", cwd, strerror(errno));
+
+		argc = 1;
+		for (pos = strlen(cwd) + 1; pos < len; pos += strlen(buf + pos) + 1)
+			argc++;
+		argv = malloc((argc + 1) * sizeof(*argv));
+		if (!argv)
+			sm_fatal("%s: out of memory", __func__);
+		argv[0] = (char *)"smatch";
+		argc = 1;
+		for (pos = strlen(cwd) + 1; pos < len; pos += strlen(buf + pos) + 1)
+			argv[argc++] = buf + pos;
+		argv[argc] = NULL;
+
+		*argcp = argc;
+		*argvp = argv;
+		return;
+	}
+
+	for (i = 0; i < 3; i++)
+		close(fds[i]);
+	while (waitpid(pid, &wstatus, 0) < 0) {
+		if (errno != EINTR)
+			exit(1);
+	}
+	if (WIFEXITED(wstatus))
+		status = WEXITSTATUS(wstatus);
+	else
+		status = 128 + WTERMSIG(wstatus);
+	write_all(conn, &status, sizeof(status));
+	exit(0);
+}
+
+void run_fork_server(const char *path, int *argcp, char ***argvp)
+{
+	struct sockaddr_un addr;
+	int sock, conn;
+	pid_t pid;
+
+	fill_addr(&addr, path);
+	unlink(path);
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0 ||
+	    bind(sock, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(sock, 128))
+		sm_fatal("cannot listen on '%s': %s", path, strerror(errno));
+
+	/* the connection handlers are reaped automatically */
+	signal(SIGCHLD, SIG_IGN);
+
+	while (1) {
+		conn = accept(sock, NULL, NULL);
+		if (conn < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			sm_fatal("accept: %s", strerror(errno));
+		}
+
+		fflush(NULL);
+		pid = fork();
+		if (pid == 0) {
+			close(sock);
+			handle_connection(conn, argcp, argvp);
+			return;
+		}
+		close(conn);
+	}
+}
@@ -75,6 +75,7 @@
 
 struct fcall_back {
 	int type;
+	int owner;
 	struct data_range *range;
 	union {
 		func_hook *call_back;
@@ -122,6 +123,7 @@ struct param_data {
 
 struct return_implies_callback {
 	int type;
+	int owner;
 	bool param_key;
 	union {
 		return_implies_hook *callback;
@@ -194,6 +196,7 @@ static void parse_fake_calls(struct expression *expr)
 	real_call = orig;
 }
 
+extern int __cur_check_id;
 static struct fcall_back *alloc_fcall_back(int type, void *call_back,
 					   void *info)
 {
@@ -201,6 +204,7 @@ static struct fcall_back *alloc_fcall_back(int type, void *call_back,
 
 	cb = __alloc_fcall_back(0);
 	cb->type = type;
+	cb->owner = __cur_check_id;
 	cb->u.call_back = call_back;
 	cb->info = info;
 	return cb;
@@ -530,6 +534,7 @@ static struct return_implies_callback *alloc_db_return_callback(int type, bool p
 
 	cb = __alloc_return_implies_callback(0);
 	cb->type = type;
+	cb->owner = __cur_check_id;
 	cb->param_key = param_key;
 	cb->callback = callback;
 
@@ -548,12 +553,16 @@ static void call_db_return_callback(struct db_callback_info *db_info,
 				    struct return_implies_callback *cb,
 				    int param, char *key, char *value)
 {
+	int prev;
+
+	prev = start_check_profile(cb->owner);
 	if (cb->param_key) {
 		db_helper(db_info->expr, cb->pk_callback, param, key, NULL);
 		add_ptr_list(&db_info->called, cb);
 	} else {
 		cb->callback(db_info->expr, param, key, value);
 	}
+	stop_check_profile(prev);
 }
 
 void select_return_param_key(int type, param_key_hook *callback)
@@ -584,10 +593,13 @@ static bool call_call_backs(struct call_back_list *list, int type,
 {
 	struct fcall_back *tmp;
 	bool handled = false;
+	int prev;
 
 	FOR_EACH_PTR(list, tmp) {
 		if (tmp->type == type) {
+			prev = start_check_profile(tmp->owner);
 			(tmp->u.call_back)(fn, expr, tmp->info);
+			stop_check_profile(prev);
 			handled = true;
 		}
 	} END_FOR_EACH_PTR(tmp);
@@ -625,9 +637,12 @@ static void call_ranged_call_backs(struct call_back_list *list,
 				struct expression *assign_expr)
 {
 	struct fcall_back *tmp;
+	int prev;
 
 	FOR_EACH_PTR(list, tmp) {
+		prev = start_check_profile(tmp->owner);
 		(tmp->u.ranged)(fn, call_expr, assign_expr, tmp->info);
+		stop_check_profile(prev);
 	} END_FOR_EACH_PTR(tmp);
 }
 
@@ -742,6 +757,7 @@ static void call_implies_callbacks(int comparison, struct expression *expr, sval
 	struct stree *true_states = NULL;
 	struct stree *false_states = NULL;
 	struct stree *tmp_stree;
+	int prev;
 
 	*implied_true = NULL;
 	*implied_false = NULL;
@@ -759,7 +775,9 @@ static void call_implies_callbacks(int comparison, struct expression *expr, sval
 			continue;
 		if (!true_comparison_range_LR(comparison, tmp->range, value_range, left))
 			continue;
+		prev = start_check_profile(tmp->owner);
 		(tmp->u.ranged)(fn_name, expr, NULL, tmp->info);
+		stop_check_profile(prev);
 	} END_FOR_EACH_PTR(tmp);
 	tmp_stree = __pop_fake_cur_stree();
 	merge_fake_stree(&true_states, tmp_stree);
@@ -773,7 +791,9 @@ static void call_implies_callbacks(int comparison, struct expression *expr, sval
 			continue;
 		if (!false_comparison_range_LR(comparison, tmp->range, value_range, left))
 			continue;
+		prev = start_check_profile(tmp->owner);
 		(tmp->u.ranged)(fn_name, expr, NULL, tmp->info);
+		stop_check_profile(prev);
 	} END_FOR_EACH_PTR(tmp);
 	tmp_stree = __pop_fake_cur_stree();
 	merge_fake_stree(&false_states, tmp_stree);
@@ -800,6 +820,7 @@ static void call_cull_hooks(struct db_callback_info *db_info, struct range_list
 	struct call_back_list *call_backs;
 	struct fcall_back *tmp;
 	const char *fn_name;
+	int prev;
 
 	while (expr->type == EXPR_ASSIGNMENT)
 		expr = strip_expr(expr->right);
@@ -814,8 +835,10 @@ static void call_cull_hooks(struct db_callback_info *db_info, struct range_list
 	FOR_EACH_PTR(call_backs, tmp) {
 		if (tmp->type != CULL_HOOK)
 			continue;
+		prev = start_check_profile(tmp->owner);
 		if ((tmp->u.cull_hook)(db_info->expr, rl, tmp->info))
 			db_info->cull = 1;
+		stop_check_profile(prev);
 	} END_FOR_EACH_PTR(tmp);
 }
 
@@ -1190,7 +1213,7 @@ static void process_return_states(struct db_callback_info *db_info)
 		       db_info->cull ? "Culling" : "Merging",
 		       expr_to_str(db_info->expr),
 		       db_info->ret_str, show_rl(db_info->rl),
-		       db_info->ret_state ? db_info->ret_state->name : "<none>");
+		       db_info->ret_state ? show_state(db_info->ret_state) : "<none>");
 		__print_stree(stree);
 	}
 
@@ -1449,6 +1472,7 @@ static void call_ranged_return_hooks(struct db_callback_info *db_info)
 	struct expression *expr;
 	struct fcall_back *tmp;
 	const char *fn_name;
+	int prev;
 
 	expr = strip_expr(db_info->expr);
 	while (expr->type == EXPR_ASSIGNMENT)
@@ -1463,8 +1487,11 @@ static void call_ranged_return_hooks(struct db_callback_info *db_info)
 			continue;
 		range_rl = alloc_rl(tmp->range->min, tmp->range->max);
 		range_rl = cast_rl(estate_type(db_info->ret_state), range_rl);
-		if (possibly_true_rl(range_rl, SPECIAL_EQUAL, estate_rl(db_info->ret_state)))
-			(tmp->u.ranged)(fn_name, expr, db_info->expr, tmp->info);
+		if (!possibly_true_rl(range_rl, SPECIAL_EQUAL, estate_rl(db_info->ret_state)))
+			continue;
+		prev = start_check_profile(tmp->owner);
+		(tmp->u.ranged)(fn_name, expr, db_info->expr, tmp->info);
+		stop_check_profile(prev);
 	} END_FOR_EACH_PTR(tmp);
 
 	FOR_EACH_PTR(call_backs, tmp) {
@@ -1485,7 +1512,9 @@ static void call_ranged_return_hooks(struct db_callback_info *db_info)
 		if (remove_range(estate_rl(db_info->ret_state),
 				 rl_min(range_rl), rl_max(range_rl)))
 			continue;
+		prev = start_check_profile(tmp->owner);
 		(tmp->u.ranged)(fn_name, expr, db_info->expr, tmp->info);
+		stop_check_profile(prev);
 	} END_FOR_EACH_PTR(tmp);
 }
 
@@ -1585,7 +1614,7 @@ static int db_return_states_assign(struct expression *expr)
 		sm_msg("%s return_id %d return_ranges %s",
 			db_info.cull ? "culled" : "merging",
 			db_info.prev_return_id,
-			db_info.ret_state ? db_info.ret_state->name : "'<empty>'");
+			db_info.ret_state ? show_state(db_info.ret_state) : "'<empty>'");
 	}
 	if (db_info.handled)
 		call_ranged_return_hooks(&db_info);
@@ -1833,6 +1862,7 @@ bool get_implied_return(struct expression *expr, struct range_list **rl)
 	struct fcall_back *tmp;
 	bool handled = false;
 	char *fn;
+	int prev;
 
 	*rl = NULL;
 
@@ -1844,8 +1874,11 @@ bool get_implied_return(struct expression *expr, struct range_list **rl)
 	call_backs = search_callback(func_hash, fn);
 
 	FOR_EACH_PTR(call_backs, tmp) {
-		if (tmp->type == IMPLIED_RETURN)
-			handled |= (tmp->u.implied_return)(expr, tmp->info, rl);
+		if (tmp->type != IMPLIED_RETURN)
+			continue;
+		prev = start_check_profile(tmp->owner);
+		handled |= (tmp->u.implied_return)(expr, tmp->info, rl);
+		stop_check_profile(prev);
 	} END_FOR_EACH_PTR(tmp);
 
 out:
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2026 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * --function-jobs=<n> analyzes the functions in a file using <n> forked
+ * workers.  The global pass is done before the fork so every worker starts
+ * with the same global_states.  A worker is a copy of the whole process so
+ * cur_func, the stree stacks and all the other per function state are
+ * private to it without changing any of the checks.
+ *
+ * The workers take functions from a shared counter, biggest first.  For
+ * each function they save what was printed and which inline functions were
+ * called to a temporary file.  Afterwards the parent goes through the
+ * functions in the normal order, prints the saved output and analyzes the
+ * inline functions itself so the output is the same as a serial run.  If a
+ * worker dies then the functions it didn't finish are analyzed again in the
+ * parent.
+ *
+ * The --info output depends on state which is collected across the whole
+ * file and printed at the END_FILE_HOOK so that is always done serially.
+ *
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "smatch.h"
+
+int option_function_jobs;
+
+struct job_result {
+	struct symbol *sym;
+	int lines;
+	bool done;
+	char *buf;
+	size_t len;
+	int nr_checks;
+	int nr_errors;
+	struct symbol_list *inlines;
+};
+
+struct job_record {
+	uint32_t idx;
+	uint32_t len;
+	uint32_t nr_inlines;
+	int32_t nr_checks;
+	int32_t nr_errors;
+};
+
+static struct job_result *results;
+static int nr_results;
+static int next_result;
+static int *order;
+
+static void (*split_fn)(struct symbol *sym);
+static void (*add_inline_fn)(struct symbol *sym);
+
+static bool in_worker;
+static struct symbol_list *worker_inlines;
+
+bool in_function_job_worker(void)
+{
+	return in_worker;
+}
+
+void function_job_add_inline(struct symbol *sym)
+{
+	add_ptr_list(&worker_inlines, sym);
+}
+
+static void save_result(FILE *out, int idx, char *buf, size_t len,
+			int nr_checks, int nr_errors)
+{
+	struct job_record rec = {};
+	struct symbol *sym;
+
+	rec.idx = idx;
+	rec.len = len;
+	rec.nr_inlines = ptr_list_size((struct ptr_list *)worker_inlines);
+	rec.nr_checks = nr_checks;
+	rec.nr_errors = nr_errors;
+
+	if (fwrite(&rec, sizeof(rec), 1, out) != 1 ||
+	    fwrite(buf, 1, len, out) != len)
+		_exit(1);
+	FOR_EACH_PTR(worker_inlines, sym) {
+		if (fwrite(&sym, sizeof(sym), 1, out) != 1)
+			_exit(1);
+	} END_FOR_EACH_PTR(sym);
+	/* only finished records are seen by the parent */
+	if (fflush(out))
+		_exit(1);
+}
+
+static void __attribute__((noreturn)) run_worker(FILE *out, int *counter)
+{
+	int nr_checks, nr_errors;
+	char *buf;
+	size_t len;
+	int idx;
+
+	in_worker = true;
+	while ((idx = __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED)) < nr_results) {
+		idx = order[idx];
+
+		buf = NULL;
+		len = 0;
+		sm_outfd = open_memstream(&buf, &len);
+		if (!sm_outfd)
+			_exit(1);
+		sql_outfd = sm_outfd;
+		caller_info_fd = sm_outfd;
+		nr_checks = sm_nr_checks;
+		nr_errors = sm_nr_errors;
+
+		split_fn(results[idx].sym);
+
+		fclose(sm_outfd);
+		save_result(out, idx, buf, len, sm_nr_checks - nr_checks,
+			    sm_nr_errors - nr_errors);
+		free(buf);
+		free_ptr_list(&worker_inlines);
+	}
+	_exit(0);
+}
+
+static void load_results(FILE *fp)
+{
+	struct job_record rec;
+	struct job_result *res;
+	struct symbol *sym;
+	int i;
+
+	rewind(fp);
+	while (fread(&rec, sizeof(rec), 1, fp) == 1) {
+		if (rec.idx >= nr_results)
+			return;
+		res = &results[rec.idx];
+		res->buf = malloc(rec.len);
+		if (!res->buf)
+			sm_fatal("%s: out of memory", __func__);
+		if (fread(res->buf, 1, rec.len, fp) != rec.len)
+			goto truncated;
+		res->len = rec.len;
+		for (i = 0; i < rec.nr_inlines; i++) {
+			if (fread(&sym, sizeof(sym), 1, fp) != 1)
+				goto truncated;
+			add_ptr_list(&res->inlines, sym);
+		}
+		res->nr_checks = rec.nr_checks;
+		res->nr_errors = rec.nr_errors;
+		res->done = true;
+	}
+	return;
+
+truncated:
+	free(res->buf);
+	res->buf = NULL;
+	free_ptr_list(&res->inlines);
+}
+
+static int cmp_lines(const void *_a, const void *_b)
+{
+	int a = *(const int *)_a;
+	int b = *(const int *)_b;
+
+	if (results[a].lines != results[b].lines)
+		return results[a].lines > results[b].lines ? -1 : 1;
+	return a - b;
+}
+
+/*
+ * We don't know where a function ends so guess the size from where the next
+ * one starts.  The last function is started first.
+ */
+static void sort_by_size(void)
+{
+	struct position pos, next;
+	int i;
+
+	for (i = 0; i < nr_results; i++) {
+		order[i] = i;
+		results[i].lines = INT_MAX;
+		if (i + 1 == nr_results)
+			continue;
+		pos = results[i].sym->pos;
+		next = results[i + 1].sym->pos;
+		if (pos.stream == next.stream && next.line >= pos.line)
+			results[i].lines = next.line - pos.line;
+	}
+	qsort(order, nr_results, sizeof(*order), cmp_lines);
+}
+
+void start_function_jobs(struct symbol_list *fns,
+			 void (*split)(struct symbol *sym),
+			 void (*add_inline)(struct symbol *sym))
+{
+	struct symbol *sym;
+	FILE **files;
+	pid_t *pids;
+	int *counter;
+	int nr_workers;
+	int status;
+	int i;
+
+	if (option_function_jobs < 2 || option_info)
+		return;
+	nr_results = ptr_list_size((struct ptr_list *)fns);
+	if (nr_results < 2)
+		return;
+
+	split_fn = split;
+	add_inline_fn = add_inline;
+	next_result = 0;
+	results = calloc(nr_results, sizeof(*results));
+	order = malloc(nr_results * sizeof(*order));
+	if (!results || !order)
+		sm_fatal("%s: out of memory", __func__);
+	i = 0;
+	FOR_EACH_PTR(fns, sym) {
+		results[i++].sym = sym;
+	} END_FOR_EACH_PTR(sym);
+	sort_by_size();
+
+	counter = mmap(NULL, sizeof(*counter), PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (counter == MAP_FAILED)
+		return;
+	*counter = 0;
+
+	nr_workers = option_function_jobs;
+	if (nr_workers > nr_results)
+		nr_workers = nr_results;
+	files = calloc(nr_workers, sizeof(*files));
+	pids = calloc(nr_workers, sizeof(*pids));
+	if (!files || !pids)
+		sm_fatal("%s: out of memory", __func__);
+
+	fflush(NULL);
+	for (i = 0; i < nr_workers; i++) {
+		pids[i] = -1;
+		files[i] = tmpfile();
+		if (!files[i])
+			continue;
+		pids[i] = fork();
+		if (pids[i] == 0)
+			run_worker(files[i], counter);
+	}
+
+	for (i = 0; i < nr_workers; i++) {
+		if (pids[i] > 0) {
+			while (waitpid(pids[i], &status, 0) < 0 && errno == EINTR)
+				;
+			load_results(files[i]);
+		}
+		if (files[i])
+			fclose(files[i]);
+	}
+
+	munmap(counter, sizeof(*counter));
+	free(files);
+	free(pids);
+}
+
+/*
+ * Called for each function in the normal order.  Returns false if the
+ * caller has to analyze the function itself.
+ */
+bool finish_function_job(struct symbol *sym)
+{
+	struct job_result *res;
+	struct symbol *tmp;
+
+	if (!results || next_result >= nr_results)
+		return false;
+	res = &results[next_result];
+	if (res->sym != sym)
+		return false;
+	next_result++;
+	if (!res->done)
+		return false;
+
+	fwrite(res->buf, 1, res->len, sm_outfd);
+	sm_nr_checks += res->nr_checks;
+	sm_nr_errors += res->nr_errors;
+	FOR_EACH_PTR(res->inlines, tmp) {
+		add_inline_fn(tmp);
+	} END_FOR_EACH_PTR(tmp);
+	return true;
+}
+
+void end_function_jobs(void)
+{
+	int i;
+
+	if (!results)
+		return;
+	for (i = 0; i < nr_results; i++) {
+		free(results[i].buf);
+		free_ptr_list(&results[i].inlines);
+	}
+	free(results);
+	free(order);
+	results = NULL;
+	order = NULL;
+	nr_results = 0;
+}
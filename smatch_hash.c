@@ -15,32 +15,81 @@
  * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
  */
 
+/*
+ * The file ids, the mtags and the hash_string table in the DB all come from
+ * this hash so the output is part of the DB format.
+ *
+ * DB format v1 used the first 8 bytes of the SHA-1.  DB format v2 (the
+ * current one) uses MurmurHash64A with SM_HASH_SEED, reading the string as
+ * little endian 64 bit words so it's the same on every host.  The top bit
+ * is cleared in both.  smatch_data/db/rekey_hashes.py converts a v1 DB.
+ *
+ * Changing the hash means bumping SMATCH_DB_FORMAT in smatch_db.c and
+ * create_db.sh.
+ *
+ */
+
+#include <stdint.h>
 #include <string.h>
-#include <openssl/evp.h>
 
 #define MTAG_ALIAS_BIT (1ULL << 63)
+#define SM_HASH_SEED 0x736d617463680002ULL
 
-unsigned long long str_to_llu_hash_helper(const char *str)
+static uint64_t load_le64(const unsigned char *p)
 {
-	unsigned char c[EVP_MAX_MD_SIZE];
-	unsigned long long *tag = (unsigned long long *)&c;
-	EVP_MD_CTX *mdctx;
-	const EVP_MD *md;
-	int len;
+	return (uint64_t)p[0] | (uint64_t)p[1] << 8 |
+	       (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+	       (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 |
+	       (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
 
-	len = strlen(str);
+static uint64_t murmur_hash64a(const void *key, size_t len, uint64_t seed)
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+	const unsigned char *data = key;
+	const unsigned char *end = data + (len & ~(size_t)7);
+	uint64_t h = seed ^ (len * m);
+	uint64_t k;
 
-	mdctx = EVP_MD_CTX_create();
-	md = EVP_sha1();
+	while (data != end) {
+		k = load_le64(data);
+		data += 8;
 
-	EVP_DigestInit_ex(mdctx, md, NULL);
-	EVP_DigestUpdate(mdctx, str, len);
-	EVP_DigestFinal_ex(mdctx, c, NULL);
-	EVP_MD_CTX_destroy(mdctx);
+		k *= m;
+		k ^= k >> r;
+		k *= m;
 
-	/* I don't like negatives in the DB */
-	*tag &= ~MTAG_ALIAS_BIT;
+		h ^= k;
+		h *= m;
+	}
 
-	return *tag;
+	switch (len & 7) {
+	case 7: h ^= (uint64_t)data[6] << 48; /* fallthrough */
+	case 6: h ^= (uint64_t)data[5] << 40; /* fallthrough */
+	case 5: h ^= (uint64_t)data[4] << 32; /* fallthrough */
+	case 4: h ^= (uint64_t)data[3] << 24; /* fallthrough */
+	case 3: h ^= (uint64_t)data[2] << 16; /* fallthrough */
+	case 2: h ^= (uint64_t)data[1] << 8; /* fallthrough */
+	case 1: h ^= (uint64_t)data[0];
+		h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return h;
 }
 
+unsigned long long str_to_llu_hash_helper(const char *str)
+{
+	unsigned long long tag;
+
+	tag = murmur_hash64a(str, strlen(str), SM_HASH_SEED);
+
+	/* I don't like negatives in the DB */
+	tag &= ~MTAG_ALIAS_BIT;
+
+	return tag;
+}
@@ -79,21 +79,28 @@ struct smatch_state *clone_state_perm(struct smatch_state *state)
 	struct smatch_state *ret;
 
 	ret = malloc(sizeof(*ret));
-	ret->name = alloc_string(state->name);
+	ret->name = alloc_string(show_state(state));
 	ret->data = state->data;
+	ret->render = NULL;
 
 	return ret;
 }
 
+static const char *render_state_num(struct smatch_state *state)
+{
+	static char buff[256];
+
+	snprintf(buff, 255, "%d", PTR_INT(state->data));
+	buff[255] = '\0';
+	return alloc_string(buff);
+}
+
 struct smatch_state *alloc_state_num(int num)
 {
 	struct smatch_state *state;
-	static char buff[256];
 
 	state = __alloc_smatch_state(0);
-	snprintf(buff, 255, "%d", num);
-	buff[255] = '\0';
-	state->name = alloc_string(buff);
+	state->render = render_state_num;
 	state->data = INT_PTR(num);
 	return state;
 }
@@ -109,9 +116,9 @@ struct smatch_state *alloc_state_str(const char *name)
 
 struct smatch_state *merge_str_state(struct smatch_state *s1, struct smatch_state *s2)
 {
-	if (!s1->name || !s2->name)
+	if (!show_state(s1) || !show_state(s2))
 		return &merged;
-	if (strcmp(s1->name, s2->name) == 0)
+	if (strcmp(show_state(s1), show_state(s2)) == 0)
 		return s1;
 	return &merged;
 }
@@ -426,31 +433,82 @@ static int __get_variable_from_expr(struct symbol **sym_ptr, char *buf,
 	}
 }
 
+/*
+ * The same expressions get turned into strings over and over by different
+ * checks.  The names only depend on the expression so they are cached in
+ * a hash table until the end of the function.
+ */
 struct expr_str_cache_results {
 	struct expression *expr;
-	char str[VAR_LEN];
+	char *str;
 	struct symbol *sym;
 	int complicated;
 };
 
+static struct expr_str_cache_results *expr_str_cache;
+static int expr_str_cache_size;
+static int expr_str_cache_used;
+unsigned long expr_str_cache_hits, expr_str_cache_misses;
+
+static struct expr_str_cache_results *find_expr_str_slot(struct expression *expr)
+{
+	unsigned int i;
+
+	i = hash_mix(0, (unsigned long)expr) & (expr_str_cache_size - 1);
+	while (expr_str_cache[i].expr && expr_str_cache[i].expr != expr)
+		i = (i + 1) & (expr_str_cache_size - 1);
+	return &expr_str_cache[i];
+}
+
+static void grow_expr_str_cache(void)
+{
+	struct expr_str_cache_results *old = expr_str_cache;
+	int old_size = expr_str_cache_size;
+	int i;
+
+	expr_str_cache_size = old_size ? old_size * 2 : 1024;
+	expr_str_cache = calloc(expr_str_cache_size, sizeof(*expr_str_cache));
+	if (!expr_str_cache)
+		sm_fatal("%s: out of memory", __func__);
+
+	for (i = 0; i < old_size; i++) {
+		if (old[i].expr)
+			*find_expr_str_slot(old[i].expr) = old[i];
+	}
+	free(old);
+}
+
+static void clear_expr_str_cache(void)
+{
+	int i;
+
+	for (i = 0; i < expr_str_cache_size; i++)
+		free(expr_str_cache[i].str);
+	free(expr_str_cache);
+	expr_str_cache = NULL;
+	expr_str_cache_size = 0;
+	expr_str_cache_used = 0;
+}
+
 static void get_variable_from_expr(struct symbol **sym_ptr, char *buf,
 				     struct expression *expr, int len,
 				     int *complicated)
 {
-	static struct expr_str_cache_results cached[8];
+	struct expr_str_cache_results *cached;
 	struct symbol *tmp_sym = NULL;
-	static int idx;
-	int i;
 
-	for (i = 0; i < ARRAY_SIZE(cached); i++) {
-		if (expr == cached[i].expr) {
-			strncpy(buf, cached[i].str, len);
+	if (expr_str_cache) {
+		cached = find_expr_str_slot(expr);
+		if (cached->expr) {
+			expr_str_cache_hits++;
+			strncpy(buf, cached->str, len);
 			if (sym_ptr)
-				*sym_ptr = cached[i].sym;
-			*complicated = cached[i].complicated;
+				*sym_ptr = cached->sym;
+			*complicated = cached->complicated;
 			return;
 		}
 	}
+	expr_str_cache_misses++;
 
 	__get_variable_from_expr(&tmp_sym, buf, expr, 0, len, complicated);
 	if (sym_ptr)
@@ -459,12 +517,16 @@ static void get_variable_from_expr(struct symbol **sym_ptr, char *buf,
 	if (expr->smatch_flags & Tmp)
 		return;
 
-	cached[idx].expr = expr;
-	strncpy(cached[idx].str, buf, VAR_LEN);
-	cached[idx].sym = tmp_sym;
-	cached[idx].complicated = *complicated;
-
-	idx = (idx + 1) % ARRAY_SIZE(cached);
+	if ((expr_str_cache_used + 1) * 2 > expr_str_cache_size)
+		grow_expr_str_cache();
+	cached = find_expr_str_slot(expr);
+	cached->expr = expr;
+	cached->str = strdup(buf);
+	if (!cached->str)
+		sm_fatal("%s: out of memory", __func__);
+	cached->sym = tmp_sym;
+	cached->complicated = *complicated;
+	expr_str_cache_used++;
 }
 
 /*
@@ -743,6 +805,8 @@ const char *show_state(struct smatch_state *state)
 {
 	if (!state)
 		return NULL;
+	if (!state->name && state->render)
+		state->name = state->render(state);
 	return state->name;
 }
 
@@ -1241,6 +1305,7 @@ void clear_strip_cache(void)
 	memset(strip_no_cast_cache, 0, sizeof(strip_no_cast_cache));
 	memset(strip_set_parent_cache, 0, sizeof(strip_set_parent_cache));
 	memset(member_cache, 0, sizeof(member_cache));
+	clear_expr_str_cache();
 }
 
 int cmp_pos(struct position pos1, struct position pos2)
@@ -152,11 +152,13 @@ static void pass_sym_list_to_client(void *fn, void *data)
 void __pass_to_client(void *data, enum hook_type type)
 {
 	struct hook_container *container;
+	int prev;
 
 	if (__debug_skip)
 		return;
 
 	FOR_EACH_PTR(hook_array[type], container) {
+		prev = start_check_profile(container->owner);
 		switch (data_types[type]) {
 		case EXPR_PTR:
 			pass_expr_to_client(container->fn, data);
@@ -173,6 +175,7 @@ void __pass_to_client(void *data, enum hook_type type)
 		default:
 			sm_warning("internal error. Unhandled hook type: %d", type);
 		}
+		stop_check_profile(prev);
 	} END_FOR_EACH_PTR(container);
 }
 
@@ -182,9 +185,12 @@ void __pass_case_to_client(struct expression *switch_expr,
 	typedef void (case_func)(struct expression *switch_expr,
 				 struct range_list *rl);
 	struct hook_container *container;
+	int prev;
 
 	FOR_EACH_PTR(hook_array[CASE_HOOK], container) {
+		prev = start_check_profile(container->owner);
 		((case_func *)container->fn)(switch_expr, rl);
+		stop_check_profile(prev);
 	} END_FOR_EACH_PTR(container);
 }
 
@@ -203,41 +209,57 @@ struct smatch_state *__client_merge_function(int owner,
 					     struct smatch_state *s1,
 					     struct smatch_state *s2)
 {
-	struct smatch_state *tmp_state;
+	struct smatch_state *tmp_state, *ret;
 	struct hook_container *tmp;
+	int prev;
 
 	/* Pass NULL states first and the rest alphabetically by name */
-	if (!s2 || (s1 && strcmp(s2->name, s1->name) < 0)) {
+	if (!s2 || (s1 && strcmp(show_state(s2), show_state(s1)) < 0)) {
 		tmp_state = s1;
 		s1 = s2;
 		s2 = tmp_state;
 	}
 
 	FOR_EACH_PTR(merge_funcs, tmp) {
-		if (tmp->owner == owner)
-			return ((merge_func_t *)tmp->fn)(s1, s2);
+		if (tmp->owner != owner)
+			continue;
+		prev = start_check_profile(owner);
+		ret = ((merge_func_t *)tmp->fn)(s1, s2);
+		stop_check_profile(prev);
+		return ret;
 	} END_FOR_EACH_PTR(tmp);
 	return &undefined;
 }
 
 struct smatch_state *__client_unmatched_state_function(struct sm_state *sm)
 {
+	struct smatch_state *ret;
 	struct hook_container *tmp;
+	int prev;
 
 	FOR_EACH_PTR(unmatched_state_funcs, tmp) {
-		if (tmp->owner == sm->owner)
-			return ((unmatched_func_t *)tmp->fn)(sm);
+		if (tmp->owner != sm->owner)
+			continue;
+		prev = start_check_profile(sm->owner);
+		ret = ((unmatched_func_t *)tmp->fn)(sm);
+		stop_check_profile(prev);
+		return ret;
 	} END_FOR_EACH_PTR(tmp);
 	return &undefined;
 }
 
 void call_pre_merge_hook(struct sm_state *cur, struct sm_state *other)
 {
+	int prev;
+
 	if (cur->owner >= num_checks)
 		return;
 
-	if (pre_merge_hooks[cur->owner])
+	if (pre_merge_hooks[cur->owner]) {
+		prev = start_check_profile(cur->owner);
 		pre_merge_hooks[cur->owner](cur, other);
+		stop_check_profile(prev);
+	}
 }
 
 static struct scope_hook_list *pop_scope_hook_list(struct scope_hook_stack **stack)
@@ -71,6 +71,41 @@ bool implied_debug;
 #define full_debug 0
 #define DIMPLIED(msg...) do { if (full_debug) printf(msg); } while (0)
 
+/*
+ * A single separate_pools() or filter_stack() is only allowed to use up a
+ * small part of the function's work budget.
+ */
+#define SEPARATE_WORK_LIMIT (option_work_budget / 60)
+#define FILTER_WORK_LIMIT (option_work_budget / 20)
+
+/*
+ * The same condition is often checked several times, for example the
+ * different CONDITION_HOOKs all look at the same sm_state.  Save the pools
+ * from separate_pools() so we only have to do it once per function.
+ *
+ * create_fake_history() changes the sm_state tree and __merge_stree() sets
+ * the ->pool of the sm_states it merges.  If either has happened since the
+ * pools were saved then they can't be re-used.
+ */
+struct pool_cache {
+	struct sm_state *sm;
+	int comparison;
+	struct range_list *rl;
+	int mixed_in;
+	int mixed_out;
+	unsigned long pool_cache_gen;
+	struct state_list *true_stack;
+	struct state_list *false_stack;
+	struct pool_cache *next;
+};
+ALLOCATOR(pool_cache, "implication pool cache");
+
+#define POOL_CACHE_SIZE 1024
+static struct pool_cache *pool_cache_table[POOL_CACHE_SIZE];
+static unsigned long pool_cache_gen;
+static unsigned long pool_cache_hits;
+static unsigned long pool_cache_misses;
+
 bool debug_implied(void)
 {
 	return option_debug || implied_debug || full_debug;
@@ -186,7 +221,7 @@ static int create_fake_history(struct sm_state *sm, int comparison, struct range
 
 	if (full_debug)
 		sm_msg("fake_history: %s vs %s.  %s %s %s. --> T: %s F: %s",
-		       sm->name, show_rl(rl), sm->state->name, show_comparison(comparison), show_rl(rl),
+		       sm->name, show_rl(rl), show_state(sm->state), show_comparison(comparison), show_rl(rl),
 		       show_rl(true_rl), show_rl(false_rl));
 
 	true_sm = clone_sm(sm);
@@ -212,6 +247,7 @@ static int create_fake_history(struct sm_state *sm, int comparison, struct range
 	sm->merged = 1;
 	sm->left = true_sm;
 	sm->right = false_sm;
+	invalidate_pool_cache();
 
 	return 1;
 }
@@ -359,21 +395,19 @@ static void __separate_pools(struct sm_state *sm, int comparison, struct range_l
 			struct state_list **maybe_stack,
 			struct state_list **false_stack,
 			struct state_list **checked, int *mixed, struct sm_state *gate_sm,
-			struct timeval *start_time)
+			unsigned long start_work)
 {
 	int free_checked = 0;
 	struct state_list *checked_states = NULL;
-	struct timeval now, diff;
 
 	if (!sm)
 		return;
 
-	gettimeofday(&now, NULL);
-	timersub(&now, start_time, &diff);
-	if (diff.tv_sec >= 1) {
+	add_work(1);
+	if (__fn_work - start_work >= SEPARATE_WORK_LIMIT) {
 		if (full_debug) {
 			sm_msg("debug: %s: implications taking too long.  (%s %s %s)",
-			       __func__, sm->state->name, show_comparison(comparison), show_rl(rl));
+			       __func__, show_state(sm->state), show_comparison(comparison), show_rl(rl));
 		}
 		if (mixed)
 			*mixed = 1;
@@ -389,8 +423,8 @@ static void __separate_pools(struct sm_state *sm, int comparison, struct range_l
 
 	do_compare(sm, comparison, rl, true_stack, maybe_stack, false_stack, mixed, gate_sm);
 
-	__separate_pools(sm->left, comparison, rl, true_stack, maybe_stack, false_stack, checked, mixed, gate_sm, start_time);
-	__separate_pools(sm->right, comparison, rl, true_stack, maybe_stack, false_stack, checked, mixed, gate_sm, start_time);
+	__separate_pools(sm->left, comparison, rl, true_stack, maybe_stack, false_stack, checked, mixed, gate_sm, start_work);
+	__separate_pools(sm->right, comparison, rl, true_stack, maybe_stack, false_stack, checked, mixed, gate_sm, start_work);
 	if (free_checked)
 		free_slist(checked);
 }
@@ -402,11 +436,8 @@ static void separate_pools(struct sm_state *sm, int comparison, struct range_lis
 {
 	struct state_list *maybe_stack = NULL;
 	struct sm_state *tmp;
-	struct timeval start_time;
-
 
-	gettimeofday(&start_time, NULL);
-	__separate_pools(sm, comparison, rl, true_stack, &maybe_stack, false_stack, checked, mixed, sm, &start_time);
+	__separate_pools(sm, comparison, rl, true_stack, &maybe_stack, false_stack, checked, mixed, sm, __fn_work);
 
 	if (full_debug) {
 		struct sm_state *sm;
@@ -437,6 +468,89 @@ static void separate_pools(struct sm_state *sm, int comparison, struct range_lis
 	} END_FOR_EACH_PTR(tmp);
 }
 
+void invalidate_pool_cache(void)
+{
+	pool_cache_gen++;
+}
+
+static unsigned int pool_cache_hash(struct sm_state *sm)
+{
+	return ((unsigned long)sm >> 4) % POOL_CACHE_SIZE;
+}
+
+static struct pool_cache *get_pool_cache(struct sm_state *sm, int comparison,
+					 struct range_list *rl, int mixed_in)
+{
+	struct pool_cache *tmp;
+
+	for (tmp = pool_cache_table[pool_cache_hash(sm)]; tmp; tmp = tmp->next) {
+		if (tmp->sm != sm || tmp->comparison != comparison ||
+		    tmp->mixed_in != mixed_in ||
+		    tmp->pool_cache_gen != pool_cache_gen)
+			continue;
+		if (!rl_equiv(tmp->rl, rl) || rl_type(tmp->rl) != rl_type(rl))
+			continue;
+		return tmp;
+	}
+	return NULL;
+}
+
+static void cached_separate_pools(struct sm_state *sm, int comparison, struct range_list *rl,
+			struct state_list **true_stack,
+			struct state_list **false_stack,
+			int *mixed)
+{
+	struct pool_cache *cache;
+	int mixed_in = mixed ? *mixed : -1;
+	unsigned int hash;
+
+	if (debug_implied()) {
+		separate_pools(sm, comparison, rl, true_stack, false_stack, NULL, mixed);
+		return;
+	}
+
+	cache = get_pool_cache(sm, comparison, rl, mixed_in);
+	if (cache) {
+		pool_cache_hits++;
+		*true_stack = clone_slist(cache->true_stack);
+		*false_stack = clone_slist(cache->false_stack);
+		if (mixed)
+			*mixed = cache->mixed_out;
+		return;
+	}
+	pool_cache_misses++;
+
+	separate_pools(sm, comparison, rl, true_stack, false_stack, NULL, mixed);
+
+	cache = __alloc_pool_cache(0);
+	cache->sm = sm;
+	cache->comparison = comparison;
+	cache->rl = clone_rl(rl);
+	cache->mixed_in = mixed_in;
+	cache->mixed_out = mixed ? *mixed : -1;
+	cache->pool_cache_gen = pool_cache_gen;
+	cache->true_stack = clone_slist(*true_stack);
+	cache->false_stack = clone_slist(*false_stack);
+	hash = pool_cache_hash(sm);
+	cache->next = pool_cache_table[hash];
+	pool_cache_table[hash] = cache;
+}
+
+static void clear_pool_cache(void)
+{
+	struct pool_cache *tmp;
+	int i;
+
+	for (i = 0; i < POOL_CACHE_SIZE; i++) {
+		for (tmp = pool_cache_table[i]; tmp; tmp = tmp->next) {
+			free_slist(&tmp->true_stack);
+			free_slist(&tmp->false_stack);
+			free_ptr_list(&tmp->rl);
+		}
+		pool_cache_table[i] = NULL;
+	}
+}
+
 static int sm_in_keep_leafs(struct sm_state *sm, const struct state_list *keep_gates)
 {
 	struct sm_state *tmp, *old;
@@ -457,18 +571,18 @@ static int going_too_slow(void)
 {
 	static void *printed;
 
-	if (out_of_memory()) {
+	if (get_mem_stage() >= MEM_NO_IMPLICATIONS) {
 		implications_off = true;
 		return 1;
 	}
 
-	if (time_parsing_function() < 60) {
+	if (work_parsing_function() < option_work_budget) {
 		implications_off = false;
 		return 0;
 	}
 
 	if (!__inline_fn && printed != cur_func_sym) {
-		sm_perror("turning off implications after 60 seconds");
+		sm_perror("turning off implications after %lu work units", option_work_budget);
 		printed = cur_func_sym;
 	}
 	implications_off = true;
@@ -488,12 +602,12 @@ static char *sm_state_info(struct sm_state *sm)
 	if (n >= sizeof(buf))
 		return buf;
 	n += snprintf(buf + n, sizeof(buf) - n, "left = %s [stree %d] ",
-		      sm->left ? sm->left->state->name : "<none>",
+		      sm->left ? show_state(sm->left->state) : "<none>",
 		      sm->left ? get_stree_id(sm->left->pool) : -1);
 	if (n >= sizeof(buf))
 		return buf;
 	n += snprintf(buf + n, sizeof(buf) - n, "right = %s [stree %d]",
-		      sm->right ? sm->right->state->name : "<none>",
+		      sm->right ? show_state(sm->right->state) : "<none>",
 		      sm->right ? get_stree_id(sm->right->pool) : -1);
 	return buf;
 }
@@ -510,21 +624,19 @@ struct sm_state *filter_pools(struct sm_state *sm,
 			      const struct state_list *remove_stack,
 			      const struct state_list *keep_stack,
 			      int *modified, int *recurse_cnt,
-			      struct timeval *start, int *skip, int *bail)
+			      unsigned long start_work, int *skip, int *bail)
 {
 	struct sm_state *ret = NULL;
 	struct sm_state *left;
 	struct sm_state *right;
 	int removed = 0;
-	struct timeval now, diff;
 
 	if (!sm)
 		return NULL;
 	if (*bail)
 		return NULL;
-	gettimeofday(&now, NULL);
-	timersub(&now, start, &diff);
-	if (diff.tv_sec >= 3) {
+	add_work(1);
+	if (__fn_work - start_work >= FILTER_WORK_LIMIT) {
 		DIMPLIED("%s: implications taking too long: %s\n", __func__, sm_state_info(sm));
 		*bail = 1;
 		return NULL;
@@ -542,7 +654,7 @@ struct sm_state *filter_pools(struct sm_state *sm,
 	}
 
 	if (!is_merged(sm) || pool_in_pools(sm->pool, keep_stack) || sm_in_keep_leafs(sm, keep_stack)) {
-		DIMPLIED("%s: keep %s (%s, %s, %s): %s\n", __func__, sm->state->name,
+		DIMPLIED("%s: keep %s (%s, %s, %s): %s\n", __func__, show_state(sm->state),
 			is_merged(sm) ? "merged" : "not merged",
 			pool_in_pools(sm->pool, keep_stack) ? "in keep pools" : "not in keep pools",
 			sm_in_keep_leafs(sm, keep_stack) ? "reachable keep leaf" : "no keep leaf",
@@ -550,8 +662,8 @@ struct sm_state *filter_pools(struct sm_state *sm,
 		return sm;
 	}
 
-	left = filter_pools(sm->left, remove_stack, keep_stack, &removed, recurse_cnt, start, skip, bail);
-	right = filter_pools(sm->right, remove_stack, keep_stack, &removed, recurse_cnt, start, skip, bail);
+	left = filter_pools(sm->left, remove_stack, keep_stack, &removed, recurse_cnt, start_work, skip, bail);
+	right = filter_pools(sm->right, remove_stack, keep_stack, &removed, recurse_cnt, start_work, skip, bail);
 	if (*bail || *skip)
 		return NULL;
 	if (!removed) {
@@ -604,25 +716,25 @@ static struct stree *filter_stack(struct sm_state *gate_sm,
 	struct sm_state *filtered_sm;
 	int modified;
 	int recurse_cnt;
-	struct timeval start;
+	unsigned long start_work;
 	int skip;
 	int bail = 0;
 
 	if (!remove_stack)
 		return NULL;
 
-	gettimeofday(&start, NULL);
+	start_work = __fn_work;
 	FOR_EACH_SM(pre_stree, tmp) {
 		if (!tmp->merged || sm_in_keep_leafs(tmp, keep_stack))
 			continue;
 		modified = 0;
 		recurse_cnt = 0;
 		skip = 0;
-		filtered_sm = filter_pools(tmp, remove_stack, keep_stack, &modified, &recurse_cnt, &start, &skip, &bail);
+		filtered_sm = filter_pools(tmp, remove_stack, keep_stack, &modified, &recurse_cnt, start_work, &skip, &bail);
 		if (going_too_slow())
 			return NULL;
 		if (bail)
-			return ret;  /* Return the implications we figured out before time ran out. */
+			return ret;  /* Return the implications we figured out before the budget ran out. */
 
 
 		if (skip || !filtered_sm || !modified)
@@ -643,21 +755,17 @@ static void separate_and_filter(struct sm_state *sm, int comparison, struct rang
 {
 	struct state_list *true_stack = NULL;
 	struct state_list *false_stack = NULL;
-	struct timeval time_before;
-	struct timeval time_after;
-	int sec;
-
-	gettimeofday(&time_before, NULL);
+	unsigned long start_work = __fn_work;
 
 	DIMPLIED("checking implications: (%s (%s) %s %s)\n",
-		 sm->name, sm->state->name, show_comparison(comparison), show_rl(rl));
+		 sm->name, show_state(sm->state), show_comparison(comparison), show_rl(rl));
 
 	if (!is_merged(sm)) {
 		DIMPLIED("%d '%s' from line %d is not merged.\n", get_lineno(), sm->name, sm->line);
 		return;
 	}
 
-	separate_pools(sm, comparison, rl, &true_stack, &false_stack, NULL, mixed);
+	cached_separate_pools(sm, comparison, rl, &true_stack, &false_stack, mixed);
 
 	if (full_debug) {
 		struct sm_state *sm;
@@ -678,10 +786,9 @@ static void separate_and_filter(struct sm_state *sm, int comparison, struct rang
 	free_slist(&true_stack);
 	free_slist(&false_stack);
 
-	gettimeofday(&time_after, NULL);
-	sec = time_after.tv_sec - time_before.tv_sec;
-	if (sec > 20)
-		sm_msg("Function too hairy.  Implications taking too long: %d seconds.", sec);
+	if (__fn_work - start_work > option_work_budget / 3)
+		sm_msg("Function too hairy.  Implications taking too long: %lu work units.",
+		       __fn_work - start_work);
 }
 
 static struct expression *get_last_expr(struct statement *stmt)
@@ -854,9 +961,9 @@ static int handled_by_comparison_hook(struct expression *expr,
 
 	true_sm = get_sm_state_stree(*implied_true, sm->owner, sm->name, sm->sym);
 	false_sm = get_sm_state_stree(*implied_false, sm->owner, sm->name, sm->sym);
-	if (true_sm && strcmp(true_sm->state->name, "unknown") == 0)
+	if (true_sm && strcmp(show_state(true_sm->state), "unknown") == 0)
 		delete_state_stree(implied_true, sm->owner, sm->name, sm->sym);
-	if (false_sm && strcmp(false_sm->state->name, "unknown") == 0)
+	if (false_sm && strcmp(show_state(false_sm->state), "unknown") == 0)
 		delete_state_stree(implied_false, sm->owner, sm->name, sm->sym);
 
 	free_stree(&pre_stree);
@@ -1015,7 +1122,7 @@ void param_limit_implications(struct expression *expr, int param, char *key, cha
 	struct symbol *left_sym = NULL;
 	int mixed = 0;
 
-	if (time_parsing_function() > 40)
+	if (work_parsing_function() > option_work_budget / 3 * 2)
 		return;
 
 	orig_expr = expr;
@@ -1134,6 +1241,23 @@ static void match_end_func(struct symbol *sym)
 	implied_debug_msg = NULL;
 }
 
+static void match_after_func(struct symbol *sym)
+{
+	if (__inline_fn)
+		return;
+
+	if (option_time && (pool_cache_hits || pool_cache_misses)) {
+		final_pass++;
+		sm_msg("implied_cache: hits %lu misses %lu (%lu%%)",
+		       pool_cache_hits, pool_cache_misses,
+		       pool_cache_hits * 100 / (pool_cache_hits + pool_cache_misses));
+		final_pass--;
+	}
+	pool_cache_hits = 0;
+	pool_cache_misses = 0;
+	clear_pool_cache();
+}
+
 static void get_tf_stacks_from_pool(struct sm_state *gate_sm,
 				    struct sm_state *pool_sm,
 				    struct state_list **true_stack,
@@ -1150,13 +1274,13 @@ static void get_tf_stacks_from_pool(struct sm_state *gate_sm,
 		return;
 
 	if (is_leaf(gate_sm) &&
-	    strcmp(gate_sm->state->name, pool_sm->state->name) == 0) {
+	    strcmp(show_state(gate_sm->state), show_state(pool_sm->state)) == 0) {
 		add_ptr_list(true_stack, pool_sm);
 		return;
 	}
 
 	FOR_EACH_PTR(gate_sm->possible, tmp) {
-		if (strcmp(tmp->state->name, pool_sm->state->name) == 0) {
+		if (strcmp(show_state(tmp->state), show_state(pool_sm->state)) == 0) {
 			possibly_true = 1;
 			break;
 		}
@@ -1258,4 +1382,6 @@ void register_implications(int id)
 	add_hook(&set_extra_implied_states, CONDITION_HOOK);
 	add_hook(&__stored_condition, CONDITION_HOOK);
 	add_hook(&match_end_func, END_FUNC_HOOK);
+	add_hook(&match_after_func, AFTER_FUNC_HOOK);
+	func_scope_pool_cache_alloc();
 }
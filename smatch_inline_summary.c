@@ -0,0 +1,391 @@
+/*
+ * Copyright (C) 2026 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * When a static function is inlined the return_states and return_implies
+ * it generates, and the caller_info for the call, are only needed until
+ * the end of the outer function.  They used to be printed as SQL, run
+ * against the in-memory SQLite DB and selected back again.  Now they are
+ * saved here in a hash table keyed by the call expression and passed to
+ * the same callbacks as the DB rows.
+ *
+ */
+
+#include "smatch.h"
+
+struct summary_row {
+	int return_id;
+	int type;
+	int param;
+	char *function;
+	char *ret;
+	char *key;
+	char *value;
+};
+
+struct summary_rows {
+	struct summary_row *rows;
+	int nr;
+	int max;
+};
+
+struct inline_summary {
+	unsigned long call_id;
+	struct summary_rows returns;
+	struct summary_rows implies;
+	struct summary_rows callers;
+};
+
+static struct inline_summary *summaries;
+static int summaries_size;
+static int summaries_used;
+
+static struct inline_summary *find_slot(unsigned long call_id)
+{
+	unsigned int i;
+
+	i = hash_mix(0, call_id) & (summaries_size - 1);
+	while (summaries[i].call_id && summaries[i].call_id != call_id)
+		i = (i + 1) & (summaries_size - 1);
+	return &summaries[i];
+}
+
+static void grow_summaries(void)
+{
+	struct inline_summary *old = summaries;
+	int old_size = summaries_size;
+	int i;
+
+	summaries_size = old_size ? old_size * 2 : 64;
+	summaries = calloc(summaries_size, sizeof(*summaries));
+	if (!summaries)
+		sm_fatal("%s: out of memory", __func__);
+
+	for (i = 0; i < old_size; i++) {
+		if (old[i].call_id)
+			*find_slot(old[i].call_id) = old[i];
+	}
+	free(old);
+}
+
+static struct inline_summary *get_summary(unsigned long call_id, bool create)
+{
+	struct inline_summary *summary;
+
+	if (!summaries) {
+		if (!create)
+			return NULL;
+		grow_summaries();
+	}
+	summary = find_slot(call_id);
+	if (summary->call_id || !create)
+		return summary->call_id ? summary : NULL;
+
+	if ((summaries_used + 1) * 2 > summaries_size) {
+		grow_summaries();
+		summary = find_slot(call_id);
+	}
+	summaries_used++;
+	summary->call_id = call_id;
+	return summary;
+}
+
+static char *dup_str(const char *str)
+{
+	char *ret;
+
+	/* this is what the SQL got from printf("'%s'") */
+	if (!str)
+		str = "(null)";
+	ret = strdup(str);
+	if (!ret)
+		sm_fatal("%s: out of memory", __func__);
+	return ret;
+}
+
+static struct summary_row *add_row(struct summary_rows *rows)
+{
+	struct summary_row *row;
+
+	if (rows->nr == rows->max) {
+		rows->max = rows->max ? rows->max * 2 : 8;
+		rows->rows = realloc(rows->rows, rows->max * sizeof(*rows->rows));
+		if (!rows->rows)
+			sm_fatal("%s: out of memory", __func__);
+	}
+	row = &rows->rows[rows->nr++];
+	memset(row, 0, sizeof(*row));
+	return row;
+}
+
+static bool str_eq(const char *a, const char *b)
+{
+	return strcmp(a, b) == 0;
+}
+
+void inline_summary_add_return(unsigned long call_id, int return_id,
+			       const char *return_ranges, int type, int param,
+			       const char *key, const char *value)
+{
+	struct summary_row *row;
+
+	row = add_row(&get_summary(call_id, true)->returns);
+	row->return_id = return_id;
+	row->ret = dup_str(return_ranges);
+	row->type = type;
+	row->param = param;
+	row->key = dup_str(key);
+	row->value = dup_str(value);
+}
+
+void inline_summary_add_implies(unsigned long call_id, const char *function,
+				int type, int param, const char *key,
+				const char *value)
+{
+	struct summary_rows *rows;
+	struct summary_row *row;
+	int i;
+
+	rows = &get_summary(call_id, true)->implies;
+
+	/* return_implies rows are unique */
+	for (i = 0; i < rows->nr; i++) {
+		row = &rows->rows[i];
+		if (row->type == type && row->param == param &&
+		    str_eq(row->function, function ? function : "(null)") &&
+		    str_eq(row->key, key ? key : "(null)") &&
+		    str_eq(row->value, value ? value : "(null)"))
+			return;
+	}
+
+	row = add_row(rows);
+	row->function = dup_str(function);
+	row->type = type;
+	row->param = param;
+	row->key = dup_str(key);
+	row->value = dup_str(value);
+}
+
+void inline_summary_add_caller(unsigned long call_id, int type, int param,
+			       const char *key, const char *value)
+{
+	struct summary_row *row;
+
+	row = add_row(&get_summary(call_id, true)->callers);
+	row->type = type;
+	row->param = param;
+	row->key = dup_str(key);
+	row->value = dup_str(value);
+}
+
+static struct summary_rows *sort_rows;
+
+static int cmp_return_rows(const void *_a, const void *_b)
+{
+	int a = *(const int *)_a;
+	int b = *(const int *)_b;
+	struct summary_row *ra = &sort_rows->rows[a];
+	struct summary_row *rb = &sort_rows->rows[b];
+
+	if (ra->return_id != rb->return_id)
+		return ra->return_id < rb->return_id ? -1 : 1;
+	if (ra->type != rb->type)
+		return ra->type < rb->type ? -1 : 1;
+	return a - b;
+}
+
+/*
+ * Same as "select return_id, return, type, parameter, key, value from
+ * return_states where call_id = ? order by return_id, type;"
+ */
+void inline_summary_select_returns(unsigned long call_id,
+				   int (*callback)(void*, int, char**, char**),
+				   void *data)
+{
+	static char *names[] = {
+		(char *)"return_id", (char *)"return", (char *)"type",
+		(char *)"parameter", (char *)"key", (char *)"value"
+	};
+	struct inline_summary *summary;
+	struct summary_row row;
+	char return_id[16], type[16], param[16];
+	char *argv[6];
+	int *order;
+	int i, nr;
+
+	summary = get_summary(call_id, false);
+	if (!summary || !summary->returns.nr)
+		return;
+
+	nr = summary->returns.nr;
+	order = malloc(nr * sizeof(*order));
+	if (!order)
+		sm_fatal("%s: out of memory", __func__);
+	for (i = 0; i < nr; i++)
+		order[i] = i;
+	sort_rows = &summary->returns;
+	qsort(order, nr, sizeof(*order), cmp_return_rows);
+
+	for (i = 0; i < nr; i++) {
+		/* the callback could add rows so don't keep pointers */
+		row = get_summary(call_id, false)->returns.rows[order[i]];
+		snprintf(return_id, sizeof(return_id), "%d", row.return_id);
+		snprintf(type, sizeof(type), "%d", row.type);
+		snprintf(param, sizeof(param), "%d", row.param);
+		argv[0] = return_id;
+		argv[1] = row.ret;
+		argv[2] = type;
+		argv[3] = param;
+		argv[4] = row.key;
+		argv[5] = row.value;
+		if (callback(data, 6, argv, names))
+			break;
+	}
+	free(order);
+}
+
+/*
+ * Same as "select distinct return from return_states where call_id = ?;"
+ */
+void inline_summary_select_return_ranges(unsigned long call_id,
+					 int (*callback)(void*, int, char**, char**),
+					 void *data)
+{
+	static char *names[] = { (char *)"return" };
+	struct inline_summary *summary;
+	char *argv[1];
+	int i, j, nr;
+
+	summary = get_summary(call_id, false);
+	if (!summary)
+		return;
+
+	nr = summary->returns.nr;
+	for (i = 0; i < nr; i++) {
+		argv[0] = summary->returns.rows[i].ret;
+		for (j = 0; j < i; j++) {
+			if (str_eq(summary->returns.rows[j].ret, argv[0]))
+				break;
+		}
+		if (j < i)
+			continue;
+		if (callback(data, 1, argv, names))
+			break;
+		summary = get_summary(call_id, false);
+	}
+}
+
+/*
+ * Same as "select function, type, parameter, key, value from
+ * return_implies where call_id = ?;"
+ */
+void inline_summary_select_implies(unsigned long call_id,
+				   int (*callback)(void*, int, char**, char**),
+				   void *data)
+{
+	static char *names[] = {
+		(char *)"function", (char *)"type", (char *)"parameter",
+		(char *)"key", (char *)"value"
+	};
+	struct inline_summary *summary;
+	struct summary_row row;
+	char type[16], param[16];
+	char *argv[5];
+	int i;
+
+	summary = get_summary(call_id, false);
+	for (i = 0; summary && i < summary->implies.nr; i++) {
+		row = summary->implies.rows[i];
+		snprintf(type, sizeof(type), "%d", row.type);
+		snprintf(param, sizeof(param), "%d", row.param);
+		argv[0] = row.function;
+		argv[1] = type;
+		argv[2] = param;
+		argv[3] = row.key;
+		argv[4] = row.value;
+		if (callback(data, 5, argv, names))
+			break;
+		summary = get_summary(call_id, false);
+	}
+}
+
+/*
+ * Same as "select call_id, type, parameter, key, value from caller_info
+ * where call_id = ?;"
+ */
+void inline_summary_select_callers(unsigned long call_id,
+				   int (*callback)(void*, int, char**, char**),
+				   void *data)
+{
+	static char *names[] = {
+		(char *)"call_id", (char *)"type", (char *)"parameter",
+		(char *)"key", (char *)"value"
+	};
+	struct inline_summary *summary;
+	struct summary_row row;
+	char id[32], type[16], param[16];
+	char *argv[5];
+	int i;
+
+	snprintf(id, sizeof(id), "%lu", call_id);
+	summary = get_summary(call_id, false);
+	for (i = 0; summary && i < summary->callers.nr; i++) {
+		row = summary->callers.rows[i];
+		snprintf(type, sizeof(type), "%d", row.type);
+		snprintf(param, sizeof(param), "%d", row.param);
+		argv[0] = id;
+		argv[1] = type;
+		argv[2] = param;
+		argv[3] = row.key;
+		argv[4] = row.value;
+		if (callback(data, 5, argv, names))
+			break;
+		summary = get_summary(call_id, false);
+	}
+}
+
+static void free_rows(struct summary_rows *rows)
+{
+	struct summary_row *row;
+	int i;
+
+	for (i = 0; i < rows->nr; i++) {
+		row = &rows->rows[i];
+		free(row->function);
+		free(row->ret);
+		free(row->key);
+		free(row->value);
+	}
+	free(rows->rows);
+}
+
+void clear_inline_summaries(void)
+{
+	int i;
+
+	for (i = 0; i < summaries_size; i++) {
+		if (!summaries[i].call_id)
+			continue;
+		free_rows(&summaries[i].returns);
+		free_rows(&summaries[i].implies);
+		free_rows(&summaries[i].callers);
+	}
+	free(summaries);
+	summaries = NULL;
+	summaries_size = 0;
+	summaries_used = 0;
+}
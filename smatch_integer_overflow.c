@@ -267,7 +267,7 @@ static void match_call_info(struct expression *call)
 		if (!link)
 			continue;
 
-		if (get_state_stree(done, my_id, link->state->name, NULL))
+		if (get_state_stree(done, my_id, show_state(link->state), NULL))
 			continue;
 //		set_state_stree(&done, my_id, link->state->name, NULL, &undefined);
 
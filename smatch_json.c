@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2026 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * --json prints each warning as one line of JSON instead of text:
+ *
+ * {"file":"foo.c","line":12,"function":"frob","check":"check_deref",
+ *  "type":"error","msg":"...","fingerprint":"0123456789abcdef"}
+ *
+ * The fingerprint is a hash of the file, function, check and message but
+ * not the line number so it doesn't change when unrelated code is added
+ * above the warning.  The whole record is written with one fwrite() and
+ * the output is fully buffered, even to a pipe.
+ *
+ */
+
+#include <stdarg.h>
+#include <unistd.h>
+#include "smatch.h"
+
+int option_json;
+
+struct json_buf {
+	char *buf;
+	size_t len;
+	size_t size;
+};
+
+static struct json_buf line;
+static struct json_buf msg_buf;
+
+static void reserve(struct json_buf *b, size_t len)
+{
+	if (b->len + len < b->size)
+		return;
+	while (b->len + len >= b->size)
+		b->size = b->size ? b->size * 2 : 1024;
+	b->buf = realloc(b->buf, b->size);
+	if (!b->buf)
+		sm_fatal("%s: out of memory", __func__);
+}
+
+static void add_raw(struct json_buf *b, const char *str)
+{
+	size_t len = strlen(str);
+
+	reserve(b, len);
+	memcpy(b->buf + b->len, str, len);
+	b->len += len;
+}
+
+static void add_string(struct json_buf *b, const char *str)
+{
+	const unsigned char *p;
+	char tmp[8];
+
+	reserve(b, 1);
+	b->buf[b->len++] = '"';
+	for (p = (const unsigned char *)(str ? str : ""); *p; p++) {
+		reserve(b, 6);
+		if (*p == '"' || *p == '\\') {
+			b->buf[b->len++] = '\\';
+			b->buf[b->len++] = *p;
+		} else if (*p < 0x20) {
+			snprintf(tmp, sizeof(tmp), "\\u%04x", *p);
+			memcpy(b->buf + b->len, tmp, 6);
+			b->len += 6;
+		} else {
+			b->buf[b->len++] = *p;
+		}
+	}
+	reserve(b, 1);
+	b->buf[b->len++] = '"';
+}
+
+static unsigned long long fingerprint(const char **parts, int nr)
+{
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	const unsigned char *p;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		for (p = (const unsigned char *)(parts[i] ? parts[i] : ""); *p; p++) {
+			hash ^= *p;
+			hash *= 0x100000001b3ULL;
+		}
+		/* separate "ab" + "c" from "a" + "bc" */
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static const char *type_name(int type)
+{
+	switch (type) {
+	case 1:
+		return "warn";
+	case 2:
+		return "error";
+	case 3:
+		return "parse error";
+	case 4:
+		return "pedantic";
+	}
+	return "msg";
+}
+
+void sm_json_msg(int type, const char *check, const char *fmt, ...)
+{
+	const char *file = get_filename();
+	const char *func = get_function();
+	const char *parts[4];
+	char tmp[64];
+	va_list args;
+	int len;
+
+	if (type == 1 || type == 2)
+		sm_nr_checks++;
+	else if (type == 3)
+		sm_nr_errors++;
+
+	va_start(args, fmt);
+	len = vsnprintf(NULL, 0, fmt, args);
+	va_end(args);
+	msg_buf.len = 0;
+	reserve(&msg_buf, len + 1);
+	va_start(args, fmt);
+	vsnprintf(msg_buf.buf, len + 1, fmt, args);
+	va_end(args);
+
+	parts[0] = file;
+	parts[1] = func;
+	parts[2] = check;
+	parts[3] = msg_buf.buf;
+
+	line.len = 0;
+	add_raw(&line, "{\"file\":");
+	add_string(&line, file);
+	snprintf(tmp, sizeof(tmp), ",\"line\":%d,\"function\":", get_lineno());
+	add_raw(&line, tmp);
+	add_string(&line, func);
+	add_raw(&line, ",\"check\":");
+	add_string(&line, check);
+	add_raw(&line, ",\"type\":");
+	add_string(&line, type_name(type));
+	add_raw(&line, ",\"msg\":");
+	add_string(&line, msg_buf.buf);
+	snprintf(tmp, sizeof(tmp), ",\"fingerprint\":\"%016llx\"}\n",
+		 fingerprint(parts, ARRAY_SIZE(parts)));
+	add_raw(&line, tmp);
+
+	fwrite(line.buf, 1, line.len, sm_outfd);
+}
+
+void sm_json_setup_stream(FILE *fp)
+{
+	if (!option_json || isatty(fileno(fp)))
+		return;
+	setvbuf(fp, NULL, _IOFBF, 1 << 20);
+}
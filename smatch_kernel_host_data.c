@@ -252,7 +252,7 @@ static void store_type_info(struct expression *expr, struct smatch_state *state)
 	if (!member)
 		return;
 
-	sql_insert_function_type_info(HOST_DATA, type_str, member, state->name);
+	sql_insert_function_type_info(HOST_DATA, type_str, member, show_state(state));
 }
 
 static void set_host_data(struct expression *expr, struct smatch_state *state)
@@ -1069,7 +1069,7 @@ static void caller_info_callback_host(struct expression *call, int param, char *
 	if (is_ignored_kernel_data(printed_name))
 		return;
 
-	if (strcmp(sm->state->name, "") == 0)
+	if (strcmp(show_state(sm->state), "") == 0)
 		return;
 
 	state = __get_state(SMATCH_EXTRA, sm->name, sm->sym);
@@ -34,13 +34,13 @@ static bool has_inc_state(const char *name, struct symbol *sym)
 		return false;
 
 	FOR_EACH_PTR(sm->possible, tmp) {
-		if (strcmp(tmp->state->name, "inc") == 0)
+		if (strcmp(show_state(tmp->state), "inc") == 0)
 			return true;
 		/*
 		 * &ignore counts as an inc, because that's what happens when
 		 * you double increment.  Not ideal.
 		 */
-		if (strcmp(tmp->state->name, "ignore") == 0)
+		if (strcmp(show_state(tmp->state), "ignore") == 0)
 			return true;
 	} END_FOR_EACH_PTR(tmp);
 
@@ -69,7 +69,7 @@ static bool refcount_bumped(const char *name, struct symbol *sym)
 		snprintf(ref, sizeof(ref), "%s->kobj.kref.refcount.refs.counter", name);
 
 	state = get_state(refcount_id, ref, sym);
-	if (state && strcmp(state->name, "inc") == 0)
+	if (state && strcmp(show_state(state), "inc") == 0)
 		return true;
 	return false;
 }
@@ -47,7 +47,7 @@ void add_set_current_state_hook(string_hook *hook)
 
 void set_task_state(struct expression *expr, struct smatch_state *state)
 {
-	call_string_hooks(hooks, expr, state->name);
+	call_string_hooks(hooks, expr, show_state(state));
 	if (get_state(my_id, "task_state", NULL))
 		complicated = true;
 	set_state(my_id, "task_state", NULL, state);
@@ -141,7 +141,7 @@ static void store_type_info(struct expression *expr, struct smatch_state *state)
 	if (!member)
 		return;
 
-	sql_insert_function_type_info(USER_DATA, type_str, member, state->name);
+	sql_insert_function_type_info(USER_DATA, type_str, member, show_state(state));
 }
 
 static void set_user_data(struct expression *expr, struct smatch_state *state)
@@ -1100,7 +1100,7 @@ static void caller_info_callback(struct expression *call, int param, char *print
 	if (strcmp(printed_name, "$") != 0 && type && type_bits(type) < type_bits(&ptr_ctype))
 		return;
 
-	if (strcmp(sm->state->name, "") == 0)
+	if (strcmp(show_state(sm->state), "") == 0)
 		return;
 
 	state = __get_state(SMATCH_EXTRA, sm->name, sm->sym);
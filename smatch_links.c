@@ -23,15 +23,14 @@
 #include "smatch.h"
 #include "smatch_slist.h"
 
-static struct smatch_state *alloc_link(struct var_sym_list *links)
+static const char *render_link(struct smatch_state *state)
 {
-	struct smatch_state *state;
+	struct var_sym_list *links = state->data;
 	static char buf[256] = "";
 	struct var_sym *tmp;
 	int cnt = 0;
 
-	state = __alloc_smatch_state(0);
-
+	buf[0] = '\0';
 	FOR_EACH_PTR(links, tmp) {
 		cnt += snprintf(buf + cnt, sizeof(buf) - cnt, "%s%s",
 				cnt ? ", " : "", tmp->var);
@@ -40,7 +39,15 @@ static struct smatch_state *alloc_link(struct var_sym_list *links)
 	} END_FOR_EACH_PTR(tmp);
 
 done:
-	state->name = alloc_sname(buf);
+	return alloc_sname(buf);
+}
+
+static struct smatch_state *alloc_link(struct var_sym_list *links)
+{
+	struct smatch_state *state;
+
+	state = __alloc_smatch_state(0);
+	state->render = render_link;
 	state->data = links;
 	return state;
 }
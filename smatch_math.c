@@ -1425,6 +1425,12 @@ static bool handle_strlen(struct expression *expr, int implied, int *recurse_cnt
 	return false;
 }
 
+/*
+ * Bumped when an RL_EXACT result depends on more than the expression so
+ * get_value() knows not to cache it.
+ */
+static unsigned long value_not_cacheable;
+
 static bool handle_builtin_constant_p(struct expression *expr, int implied, int *recurse_cnt, sval_t *res_sval)
 {
 	struct expression *arg, *assigned;
@@ -1446,6 +1452,9 @@ static bool handle_builtin_constant_p(struct expression *expr, int implied, int
 		return true;
 	}
 
+	/* the rest depends on the current path and on where we are called from */
+	value_not_cacheable++;
+
 	if (nested) {
 		*res_sval = zero;
 		return true;
@@ -1803,15 +1812,63 @@ static bool get_rl_helper(struct expression *expr, int implied, struct range_lis
 	return true;
 }
 
-static struct {
+/*
+ * get_value() results are cached by expression until the end of the
+ * function.  The sval.type is NULL if there wasn't a value.  Results which
+ * bumped value_not_cacheable, like __builtin_constant_p() of a variable,
+ * are not cached.
+ */
+struct value_cache {
 	struct expression *expr;
 	sval_t sval;
-} cached_results[24];
-static int cache_idx;
+};
+static struct value_cache *value_cache;
+static int value_cache_size;
+static int value_cache_used;
+unsigned long value_cache_hits, value_cache_misses;
+
+static struct value_cache *find_value_slot(struct expression *expr)
+{
+	unsigned int i;
+
+	i = hash_mix(0, (unsigned long)expr) & (value_cache_size - 1);
+	while (value_cache[i].expr && value_cache[i].expr != expr)
+		i = (i + 1) & (value_cache_size - 1);
+	return &value_cache[i];
+}
+
+static void add_value_cache(struct expression *expr, sval_t sval)
+{
+	struct value_cache *old = value_cache;
+	struct value_cache *slot;
+	int old_size = value_cache_size;
+	int i;
+
+	if ((value_cache_used + 1) * 2 > value_cache_size) {
+		value_cache_size = old_size ? old_size * 2 : 1024;
+		value_cache = calloc(value_cache_size, sizeof(*value_cache));
+		if (!value_cache)
+			sm_fatal("%s: out of memory", __func__);
+		for (i = 0; i < old_size; i++) {
+			if (old[i].expr)
+				*find_value_slot(old[i].expr) = old[i];
+		}
+		free(old);
+	}
+
+	slot = find_value_slot(expr);
+	if (!slot->expr)
+		value_cache_used++;
+	slot->expr = expr;
+	slot->sval = sval;
+}
 
 void clear_math_cache(void)
 {
-	memset(cached_results, 0, sizeof(cached_results));
+	free(value_cache);
+	value_cache = NULL;
+	value_cache_size = 0;
+	value_cache_used = 0;
 }
 
 void set_fast_math_only(void)
@@ -1844,9 +1901,9 @@ static bool get_value_literal(struct expression *expr, sval_t *res_sval)
 int get_value(struct expression *expr, sval_t *res_sval)
 {
 	struct range_list *(*orig_custom_fn)(struct expression *expr);
+	unsigned long not_cacheable = value_not_cacheable;
 	int recurse_cnt = 0;
 	sval_t sval = {};
-	int i;
 
 	if (get_value_literal(expr, res_sval))
 		return 1;
@@ -1855,15 +1912,19 @@ int get_value(struct expression *expr, sval_t *res_sval)
 	 * This only handles RL_EXACT because other expr statements can be
 	 * different at different points.  Like the list iterator, for example.
 	 */
-	for (i = 0; i < ARRAY_SIZE(cached_results); i++) {
-		if (expr == cached_results[i].expr) {
-			if (cached_results[i].sval.type) {
-				*res_sval = cached_results[i].sval;
+	if (value_cache) {
+		struct value_cache *cached = find_value_slot(expr);
+
+		if (cached->expr) {
+			value_cache_hits++;
+			if (cached->sval.type) {
+				*res_sval = cached->sval;
 				return true;
 			}
 			return false;
 		}
 	}
+	value_cache_misses++;
 
 	orig_custom_fn = custom_handle_variable;
 	custom_handle_variable = NULL;
@@ -1871,9 +1932,8 @@ int get_value(struct expression *expr, sval_t *res_sval)
 
 	custom_handle_variable = orig_custom_fn;
 
-	cached_results[cache_idx].expr = expr;
-	cached_results[cache_idx].sval = sval;
-	cache_idx = (cache_idx + 1) % ARRAY_SIZE(cached_results);
+	if (not_cacheable == value_not_cacheable)
+		add_value_cache(expr, sval);
 
 	if (!sval.type)
 		return 0;
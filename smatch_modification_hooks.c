@@ -291,6 +291,7 @@ void register_modification_hooks(int id)
 	my_id = id;
 
 	set_dynamic_states(my_id);
+	func_scope_modification_data_alloc();
 
 	add_hook(&match_assign_early, ASSIGNMENT_HOOK);
 	add_hook(&unop_expr_early, OP_HOOK);
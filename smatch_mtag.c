@@ -76,8 +76,57 @@ static void insert_tag_map(mtag_t tag, struct symbol *sym)
 	insert_sym(tag_sym_map, p, sym);
 }
 
+/*
+ * The file ids are hashed for every row that goes into the DB.  The
+ * hash_string table is UNIQUE (hash) so remember which hashes are already
+ * there instead of doing an "insert or ignore" each time.
+ */
+static unsigned long long *stored_hashes;
+static int stored_size;
+static int stored_used;
+
+static unsigned long long *find_stored_slot(unsigned long long hash)
+{
+	unsigned int i;
+
+	i = hash_mix(0, hash) & (stored_size - 1);
+	while (stored_hashes[i] && stored_hashes[i] != hash)
+		i = (i + 1) & (stored_size - 1);
+	return &stored_hashes[i];
+}
+
+static void grow_stored_hashes(void)
+{
+	unsigned long long *old = stored_hashes;
+	int old_size = stored_size;
+	int i;
+
+	stored_size = old_size ? old_size * 2 : 1024;
+	stored_hashes = calloc(stored_size, sizeof(*stored_hashes));
+	if (!stored_hashes)
+		sm_fatal("%s: out of memory", __func__);
+	for (i = 0; i < old_size; i++) {
+		if (old[i])
+			*find_stored_slot(old[i]) = old[i];
+	}
+	free(old);
+}
+
 static void store_hash(const char *str, unsigned long long hash)
 {
+	unsigned long long *slot;
+
+	if ((stored_used + 1) * 2 > stored_size)
+		grow_stored_hashes();
+	/* zero marks an empty slot so don't remember that one */
+	if (hash) {
+		slot = find_stored_slot(hash);
+		if (*slot)
+			return;
+		*slot = hash;
+		stored_used++;
+	}
+
 	sql_insert_cache_or_ignore(hash_string, "0x%llx, '%s'", hash, str);
 }
 
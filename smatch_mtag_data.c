@@ -39,9 +39,12 @@ static int save_rl(void *_rl, int argc, char **argv, char **azColName)
 static struct range_list *select_orig(mtag_t tag, int offset)
 {
 	struct range_list *rl = NULL;
+	struct sql_bind bind = {};
 
-	mem_sql(&save_rl, &rl, "select value from mtag_data where tag = %lld and offset = %d;",
-		tag, offset);
+	sql_bind_int(&bind, tag);
+	sql_bind_int(&bind, offset);
+	mem_sql_bound(&save_rl, &rl, &bind,
+		      "select value from mtag_data where tag = ? and offset = ?;");
 	return rl;
 }
 
@@ -117,6 +120,9 @@ static bool is_ignored_tag(mtag_t tag)
 
 static void insert_mtag_data(mtag_t tag, int offset, struct range_list *rl)
 {
+	struct sql_bind bind = {};
+	char buf[32];
+
 	if (in_fake_env)
 		return;
 	if (is_ignored_tag(tag))
@@ -124,10 +130,15 @@ static void insert_mtag_data(mtag_t tag, int offset, struct range_list *rl)
 
 	rl = clone_rl_permanent(rl);
 
-	mem_sql(NULL, NULL, "delete from mtag_data where tag = %lld and offset = %d and type = %d",
-		tag, offset, DATA_VALUE);
-	mem_sql(NULL, NULL, "insert into mtag_data values (%lld, %d, %d, '%lu');",
-		tag, offset, DATA_VALUE, (unsigned long)rl);
+	sql_bind_int(&bind, tag);
+	sql_bind_int(&bind, offset);
+	mem_sql_bound(NULL, NULL, &bind,
+		      "delete from mtag_data where tag = ? and offset = ? and type = %d",
+		      DATA_VALUE);
+	snprintf(buf, sizeof(buf), "%lu", (unsigned long)rl);
+	sql_bind_text(&bind, buf);
+	mem_sql_bound(NULL, NULL, &bind, "insert into mtag_data values (?, ?, %d, ?);",
+		      DATA_VALUE);
 }
 
 static bool invalid_type(struct symbol *type)
@@ -226,6 +237,11 @@ static int save_mtag_data(void *_unused, int argc, char **argv, char **azColName
 		return 0;
 
 	rl = (struct range_list *)strtoul(argv[3], NULL, 10);
+	if (shard_db) {
+		sql_save_shard(0, "insert or ignore into mtag_data values ('%s', '%s', '%s', '%s');",
+			       argv[0], argv[1], argv[2], show_rl(rl));
+		return 0;
+	}
 	sm_msg("SQL: insert or ignore into mtag_data values ('%s', '%s', '%s', '%s');",
 	       argv[0], argv[1], argv[2], show_rl(rl));
 
@@ -266,6 +282,7 @@ static struct db_cache_results cached_results[8];
 static int get_rl_from_mtag_offset(mtag_t tag, int offset, struct symbol *type, struct range_list **rl)
 {
 	struct db_info db_info = {};
+	struct sql_bind bind = {};
 	mtag_t merged = tag | offset;
 	struct range_list *mem_rl;
 	static int idx;
@@ -288,9 +305,11 @@ static int get_rl_from_mtag_offset(mtag_t tag, int offset, struct symbol *type,
 		goto update_cache;
 
 	db_info.type = type;
-	run_sql(get_vals, &db_info,
-		"select value from mtag_data where tag = %lld and offset = %d and type = %d;",
-		tag, offset, DATA_VALUE);
+	sql_bind_int(&bind, tag);
+	sql_bind_int(&bind, offset);
+	run_sql_bound(get_vals, &db_info, &bind,
+		"select value from mtag_data where tag = ? and offset = ? and type = %d;",
+		DATA_VALUE);
 	if (!db_info.rl)
 		goto update_cache;
 	db_info.rl = rl_union(mem_rl, db_info.rl);
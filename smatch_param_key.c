@@ -962,7 +962,7 @@ static char *handle_container_of_container_assign(struct expression *expr, int o
 		return NULL;
 	data = state->data;
 
-	if (!parse_container_string(state->name, &remove, &orig_offset, &param, &cnt, &end))
+	if (!parse_container_string(show_state(state), &remove, &orig_offset, &param, &cnt, &end))
 		return NULL;
 
 	snprintf(buf, sizeof(buf), "(%d<~$%d[%d])", orig_offset + offset, param, cnt + 1);
@@ -1101,9 +1101,9 @@ const char *get_container_of_str(struct expression *expr)
 	state = get_state_expr(my_id, expr);
 	if (!state)
 		return NULL;
-	if (!strstr(state->name, "<~$"))
+	if (!strstr(show_state(state), "<~$"))
 		return NULL;
-	return state->name;
+	return show_state(state);
 }
 
 static bool is_self_assign(struct expression *expr)
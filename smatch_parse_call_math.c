@@ -626,7 +626,7 @@ const char *get_allocation_math(struct expression *expr)
 	if (!state || !state->data)
 		return NULL;
 
-	return state->name;
+	return show_state(state);
 }
 
 void register_parse_call_math(int id)
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2026 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * --profile-checks charges the time spent in each hook to the check which
+ * registered it.  Hooks call other hooks all the time (a set_state() in one
+ * check triggers modification hooks in another) so the time is "self" time:
+ * when a nested hook starts the clock stops for the outer one.  Everything
+ * which isn't inside a hook is charged to "internal".
+ *
+ */
+
+#include <time.h>
+#include "smatch.h"
+
+int option_profile_checks;
+char *option_profile_json;
+
+struct check_profile {
+	unsigned long long nsec;
+	unsigned long calls;
+	unsigned long states;
+};
+
+static struct check_profile *profiles;
+static int cur_owner;
+static unsigned long long last_stamp;
+
+static unsigned long long now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int profile_id(int owner)
+{
+	if (owner < 0 || owner >= num_checks)
+		return 0;
+	return owner;
+}
+
+int __start_check_profile(int owner)
+{
+	unsigned long long now = now_nsec();
+	int prev = cur_owner;
+
+	owner = profile_id(owner);
+	profiles[cur_owner].nsec += now - last_stamp;
+	profiles[owner].calls++;
+	cur_owner = owner;
+	last_stamp = now;
+	return prev;
+}
+
+void __stop_check_profile(int prev)
+{
+	unsigned long long now = now_nsec();
+
+	profiles[cur_owner].nsec += now - last_stamp;
+	cur_owner = prev;
+	last_stamp = now;
+}
+
+void __profile_sm_state(int owner)
+{
+	if (!profiles)
+		return;
+	profiles[profile_id(owner)].states++;
+}
+
+void allocate_check_profile(void)
+{
+	if (!option_profile_checks)
+		return;
+
+	profiles = calloc(num_checks, sizeof(*profiles));
+	if (!profiles)
+		sm_fatal("%s: out of memory", __func__);
+	cur_owner = 0;
+	last_stamp = now_nsec();
+}
+
+static int cmp_profile(const void *_a, const void *_b)
+{
+	const struct check_profile *a = &profiles[*(const int *)_a];
+	const struct check_profile *b = &profiles[*(const int *)_b];
+
+	if (a->nsec != b->nsec)
+		return a->nsec > b->nsec ? -1 : 1;
+	if (a->calls != b->calls)
+		return a->calls > b->calls ? -1 : 1;
+	return *(const int *)_a - *(const int *)_b;
+}
+
+static void write_profile_json(int *order, int nr)
+{
+	FILE *fp;
+	int i;
+
+	fp = fopen(option_profile_json, "w");
+	if (!fp) {
+		sm_warning("cannot write '%s'", option_profile_json);
+		return;
+	}
+
+	fprintf(fp, "[\n");
+	for (i = 0; i < nr; i++) {
+		struct check_profile *p = &profiles[order[i]];
+
+		fprintf(fp, "  {\"id\": %d, \"check\": \"%s\", \"usec\": %llu, \"calls\": %lu, \"states\": %lu}%s\n",
+			order[i], check_name(order[i]), p->nsec / 1000,
+			p->calls, p->states, i + 1 < nr ? "," : "");
+	}
+	fprintf(fp, "]\n");
+	fclose(fp);
+}
+
+void show_check_profile(void)
+{
+	unsigned long long total = 0;
+	int *order;
+	int i, nr = 0;
+
+	if (!profiles)
+		return;
+
+	/* charge the time since the last hook returned */
+	__stop_check_profile(0);
+
+	order = malloc(num_checks * sizeof(*order));
+	if (!order)
+		sm_fatal("%s: out of memory", __func__);
+	for (i = 0; i < num_checks; i++) {
+		total += profiles[i].nsec;
+		if (profiles[i].nsec || profiles[i].calls || profiles[i].states)
+			order[nr++] = i;
+	}
+	qsort(order, nr, sizeof(*order), cmp_profile);
+
+	sm_msg("profile: %-40s %10s %6s %12s %12s", "check", "ms", "%", "calls", "states");
+	for (i = 0; i < nr; i++) {
+		struct check_profile *p = &profiles[order[i]];
+
+		sm_msg("profile: %-40s %10llu %6.2f %12lu %12lu",
+		       check_name(order[i]), p->nsec / 1000000,
+		       total ? p->nsec * 100.0 / total : 0.0,
+		       p->calls, p->states);
+	}
+
+	if (option_profile_json)
+		write_profile_json(order, nr);
+	free(order);
+}
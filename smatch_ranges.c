@@ -928,9 +928,97 @@ static struct data_range *alloc_range_helper_sval(sval_t min, sval_t max, int pe
 	return ret;
 }
 
+/*
+ * Most range lists only have a few ranges and the same ranges are built
+ * over and over by add_range(), cast_rl() and the other range list
+ * functions.  The ranges from alloc_range() are hash-consed so each one is
+ * only allocated once per function and equal ranges share one pointer.
+ * This means that once a data_range is in a list it must never be changed.
+ * The table is cleared along with the data_range allocator in
+ * free_data_info_allocs().
+ */
+static struct data_range **range_table;
+static int range_table_size;
+static int range_table_used;
+static unsigned long range_lookups, range_allocs;
+
+static unsigned int hash_range(sval_t min, sval_t max)
+{
+	unsigned int hash;
+
+	hash = hash_mix(0, (unsigned long)min.type);
+	hash = hash_mix(hash, min.uvalue);
+	hash = hash_mix(hash, (unsigned long)max.type);
+	return hash_mix(hash, max.uvalue);
+}
+
+static bool same_range(struct data_range *drange, sval_t min, sval_t max)
+{
+	return drange->min.type == min.type && drange->min.uvalue == min.uvalue &&
+	       drange->max.type == max.type && drange->max.uvalue == max.uvalue;
+}
+
+static struct data_range **find_range_slot(sval_t min, sval_t max)
+{
+	unsigned int i;
+
+	i = hash_range(min, max) & (range_table_size - 1);
+	while (range_table[i] && !same_range(range_table[i], min, max))
+		i = (i + 1) & (range_table_size - 1);
+	return &range_table[i];
+}
+
+static void grow_range_table(void)
+{
+	struct data_range **old = range_table;
+	int old_size = range_table_size;
+	int i;
+
+	range_table_size = old_size ? old_size * 2 : 1024;
+	range_table = calloc(range_table_size, sizeof(*range_table));
+	if (!range_table)
+		sm_fatal("%s: out of memory", __func__);
+
+	for (i = 0; i < old_size; i++) {
+		if (old[i])
+			*find_range_slot(old[i]->min, old[i]->max) = old[i];
+	}
+	free(old);
+}
+
+static void clear_range_table(void)
+{
+	if (range_table_used)
+		memset(range_table, 0, range_table_size * sizeof(*range_table));
+	range_table_used = 0;
+}
+
 struct data_range *alloc_range(sval_t min, sval_t max)
 {
-	return alloc_range_helper_sval(min, max, 0);
+	struct data_range **slot;
+
+	range_lookups++;
+	/* only part of a long double is in ->uvalue so don't share those */
+	if (type_is_fp(min.type) || type_is_fp(max.type)) {
+		range_allocs++;
+		return alloc_range_helper_sval(min, max, 0);
+	}
+
+	if ((range_table_used + 1) * 2 > range_table_size)
+		grow_range_table();
+	slot = find_range_slot(min, max);
+	if (*slot)
+		return *slot;
+
+	range_allocs++;
+	range_table_used++;
+	*slot = alloc_range_helper_sval(min, max, 0);
+	return *slot;
+}
+
+void show_range_stats(void)
+{
+	sm_msg("data ranges: requested %lu allocated %lu", range_lookups, range_allocs);
 }
 
 struct data_range *alloc_range_perm(sval_t min, sval_t max)
@@ -1018,6 +1106,7 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 {
 	struct data_range *tmp;
 	struct data_range *new = NULL;
+	struct data_range scratch;
 	int check_next = 0;
 
 	/*
@@ -1061,6 +1150,11 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 	 * with a range like 1-2.  You end up with min-2,3-max instead of
 	 * just min-max.
 	 */
+	/*
+	 * The interned ranges can't be changed so when the new range might
+	 * still grow it goes into the list as scratch and it's swapped for
+	 * an interned range at the end.
+	 */
 	FOR_EACH_PTR(*list, tmp) {
 		if (check_next) {
 			/* Sometimes we overlap with more than one range
@@ -1069,18 +1163,18 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 				/* join 2 ranges here */
 				new->max = tmp->max;
 				DELETE_CURRENT_PTR(tmp);
-				return;
+				goto intern;
 			}
 
 			/* Doesn't overlap with the next one. */
 			if (sval_cmp(max, tmp->min) < 0)
-				return;
+				goto intern;
 
 			if (sval_cmp(max, tmp->max) <= 0) {
 				/* Partially overlaps the next one. */
 				new->max = tmp->max;
 				DELETE_CURRENT_PTR(tmp);
-				return;
+				goto intern;
 			} else {
 				/* Completely overlaps the next one. */
 				DELETE_CURRENT_PTR(tmp);
@@ -1100,28 +1194,34 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 			return;
 		}
 		if (sval_cmp(min, tmp->min) < 0) { /* new range partially below */
-			if (sval_cmp(max, tmp->max) < 0)
-				max = tmp->max;
-			else
-				check_next = 1;
-			new = alloc_range(min, max);
-			REPLACE_CURRENT_PTR(tmp, new);
-			if (!check_next)
+			if (sval_cmp(max, tmp->max) < 0) {
+				new = alloc_range(min, tmp->max);
+				REPLACE_CURRENT_PTR(tmp, new);
 				return;
+			}
+			check_next = 1;
+			new = &scratch;
+			new->min = min;
+			new->max = max;
+			REPLACE_CURRENT_PTR(tmp, new);
 			continue;
 		}
 		if (sval_cmp(max, tmp->max) <= 0) /* new range already included */
 			return;
 		if (sval_cmp(min, tmp->max) <= 0) { /* new range partially above */
 			min = tmp->min;
-			new = alloc_range(min, max);
+			new = &scratch;
+			new->min = min;
+			new->max = max;
 			REPLACE_CURRENT_PTR(tmp, new);
 			check_next = 1;
 			continue;
 		}
 		if (!sval_is_min(min) && min.value - 1 == tmp->max.value) {
 			/* join 2 ranges into a big range */
-			new = alloc_range(tmp->min, max);
+			new = &scratch;
+			new->min = tmp->min;
+			new->max = max;
 			REPLACE_CURRENT_PTR(tmp, new);
 			check_next = 1;
 			continue;
@@ -1129,12 +1229,21 @@ void add_range(struct range_list **list, sval_t min, sval_t max)
 		/* the new range is entirely above the existing ranges */
 	} END_FOR_EACH_PTR(tmp);
 	if (check_next)
-		return;
+		goto intern;
 	new = alloc_range(min, max);
 
 	rl_ptrlist_hack = 1;
 	add_ptr_list(list, new);
 	rl_ptrlist_hack = 0;
+	return;
+
+intern:
+	FOR_EACH_PTR(*list, tmp) {
+		if (tmp == &scratch) {
+			REPLACE_CURRENT_PTR(tmp, alloc_range(scratch.min, scratch.max));
+			return;
+		}
+	} END_FOR_EACH_PTR(tmp);
 }
 
 struct range_list *clone_rl(struct range_list *list)
@@ -1220,7 +1329,7 @@ struct range_list *remove_range(struct range_list *list, sval_t min, sval_t max)
 
 int ranges_equiv(struct data_range *one, struct data_range *two)
 {
-	if (!one && !two)
+	if (one == two)
 		return 1;
 	if (!one || !two)
 		return 0;
@@ -1739,7 +1848,7 @@ struct range_list *rl_intersection(struct range_list *one, struct range_list *tw
 static struct range_list *get_neg_rl(struct range_list *rl)
 {
 	struct data_range *tmp;
-	struct data_range *new;
+	sval_t max;
 	struct range_list *ret = NULL;
 
 	if (!rl)
@@ -1751,9 +1860,9 @@ static struct range_list *get_neg_rl(struct range_list *rl)
 		if (sval_is_positive(tmp->min))
 			break;
 		if (sval_is_positive(tmp->max)) {
-			new = alloc_range(tmp->min, tmp->max);
-			new->max.value = -1;
-			add_range(&ret, new->min, new->max);
+			max = tmp->max;
+			max.value = -1;
+			add_range(&ret, tmp->min, max);
 			break;
 		}
 		add_range(&ret, tmp->min, tmp->max);
@@ -1765,7 +1874,7 @@ static struct range_list *get_neg_rl(struct range_list *rl)
 static struct range_list *get_pos_rl(struct range_list *rl)
 {
 	struct data_range *tmp;
-	struct data_range *new;
+	sval_t min;
 	struct range_list *ret = NULL;
 
 	if (!rl)
@@ -1780,9 +1889,9 @@ static struct range_list *get_pos_rl(struct range_list *rl)
 			add_range(&ret, tmp->min, tmp->max);
 			continue;
 		}
-		new = alloc_range(tmp->min, tmp->max);
-		new->min.value = 0;
-		add_range(&ret, new->min, new->max);
+		min = tmp->min;
+		min.value = 0;
+		add_range(&ret, min, tmp->max);
 	} END_FOR_EACH_PTR(tmp);
 
 	return ret;
@@ -2543,6 +2652,7 @@ void free_data_info_allocs(void)
 	clear_math_cache();
 	clear_strip_cache();
 
+	allocated_blob_bytes -= desc->total_bytes;
 	desc->blobs = NULL;
 	desc->allocations = 0;
 	desc->total_bytes = 0;
@@ -2555,6 +2665,7 @@ void free_data_info_allocs(void)
 	}
 	clear_array_values_cache();
 	clear_type_value_cache();
+	clear_range_table();
 	clear_data_range_alloc();
 }
 
@@ -61,7 +61,7 @@ char *map_call_to_other_name_sym(const char *name, struct symbol *sym, struct sy
 	if (!state || !state->data)
 		return NULL;
 
-	snprintf(buf, sizeof(buf), "%s->%s", state->name, name + skip);
+	snprintf(buf, sizeof(buf), "%s->%s", show_state(state), name + skip);
 	*new_sym = state->data;
 	return alloc_string(buf);
 }
@@ -73,8 +73,8 @@ static char *map_my_state_long_to_short(struct sm_state *sm, const char *name, s
 
 	if (sm->state->data != sym)
 		return NULL;
-	len = strlen(sm->state->name);
-	if (strncmp(name, sm->state->name, len) != 0)
+	len = strlen(show_state(sm->state));
+	if (strncmp(name, show_state(sm->state), len) != 0)
 		return NULL;
 
 	if (name[len] == '.')
@@ -139,7 +139,7 @@ char *map_call_to_param_name_sym(struct expression *expr, struct symbol **sym)
 		return NULL;
 
 	*sym = state->data;
-	return alloc_string(state->name);
+	return alloc_string(show_state(state));
 }
 
 static void store_mapping_helper(char *left_name, struct symbol *left_sym, struct expression *call, const char *return_string)
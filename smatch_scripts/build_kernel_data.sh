@@ -38,7 +38,7 @@ if [ ! -e smatch_db.sqlite ] ; then
 fi
 
 BUILD_STATUS=0
-$SCRIPT_DIR/test_kernel.sh --call-tree --info --spammy --data=$DATA_DIR || BUILD_STATUS=$?
+$SCRIPT_DIR/test_kernel.sh --shards --call-tree --info --spammy --data=$DATA_DIR || BUILD_STATUS=$?
 echo "smatch_warns.txt built."
 
 for i in $SCRIPT_DIR/gen_* ; do
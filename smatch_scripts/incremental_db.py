@@ -0,0 +1,190 @@
+#!/usr/bin/python3
+
+# Copyright (C) 2026 Oracle.
+#
+# Licensed under the Open Software License version 1.1
+
+# Update smatch_db.sqlite after some .c files have changed without
+# re-analyzing the whole tree.
+#
+# The changed files are re-analyzed and loaded with reload_partial.sh.  For
+# each function in those files we hash what the DB says about it before and
+# after the reload: its return_states and return_implies and the
+# caller_info for the functions it calls.  If a function's returns changed
+# then the files which call it are analyzed next.  If the caller_info for a
+# callee changed then the file where the callee is defined is analyzed next.
+# This repeats until nothing changes.
+#
+# Run it from the root of the kernel tree:
+#   git diff --name-only v6.1.. | grep '\.c$' | xargs incremental_db.py
+
+import argparse
+import hashlib
+import os
+import sqlite3
+import subprocess
+import sys
+import tempfile
+from concurrent.futures import ThreadPoolExecutor
+
+script_dir = os.path.dirname(os.path.abspath(sys.argv[0]))
+data_dir = os.path.join(script_dir, "..", "smatch_data")
+db_file = "smatch_db.sqlite"
+
+def usage_args():
+    parser = argparse.ArgumentParser(
+        description="Re-analyze changed files until smatch_db.sqlite converges.")
+    parser.add_argument("-p", "--project", default="kernel")
+    parser.add_argument("-j", "--jobs", type=int, default=1,
+                        help="number of files to analyze at the same time")
+    parser.add_argument("--max-passes", type=int, default=10)
+    parser.add_argument("--cmd",
+                        default=os.path.join(script_dir, "kchecker") +
+                                " --info --call-tree --spammy --outfile={out} {file}",
+                        help="command to analyze one file, {file} and {out} are replaced")
+    parser.add_argument("files", nargs="+")
+    return parser.parse_args()
+
+def all_c_files():
+    try:
+        out = subprocess.run(["git", "ls-files", "*.c"], capture_output=True,
+                             text=True, check=True).stdout
+        return out.split()
+    except (OSError, subprocess.CalledProcessError):
+        pass
+    files = []
+    for root, dirs, names in os.walk("."):
+        for name in names:
+            if name.endswith(".c"):
+                files.append(os.path.relpath(os.path.join(root, name)))
+    return files
+
+# The file column in the DB is the sm_hash of the file name.
+def file_ids(files):
+    sm_hash = os.path.join(data_dir, "db", "sm_hash")
+    ids = {}
+    for i in range(0, len(files), 1000):
+        chunk = files[i:i + 1000]
+        out = subprocess.run([sm_hash] + chunk, capture_output=True,
+                             text=True, check=True).stdout.split()
+        for name, hash in zip(chunk, out):
+            ids[int(hash)] = name
+    return ids
+
+def add_rows(hashes, key, row):
+    if key not in hashes:
+        hashes[key] = hashlib.sha1()
+    hashes[key].update(repr(row).encode())
+
+# The call_id columns are left out because they are renumbered every time
+# the DB is loaded.
+def summaries(files, path_to_id):
+    con = sqlite3.connect(db_file)
+    con.execute("create temp table work_files (id big int);")
+    con.executemany("insert into work_files values (?);",
+                    [(path_to_id[f],) for f in files if f in path_to_id])
+    hashes = {}
+
+    for row in con.execute("select file, function, static, return_id, return, type, parameter, key, value "
+                           "from return_states where file in (select id from work_files) "
+                           "order by file, function, return_id, type, parameter, key, value;"):
+        add_rows(hashes, ("ret", row[1], row[0] if row[2] else 0), row[3:])
+    for row in con.execute("select file, function, static, type, parameter, key, value "
+                           "from return_implies where file in (select id from work_files) "
+                           "order by file, function, type, parameter, key, value;"):
+        add_rows(hashes, ("ret", row[1], row[0] if row[2] else 0), ("implies",) + row[3:])
+    for row in con.execute("select file, caller, function, static, type, parameter, key, value "
+                           "from caller_info where file in (select id from work_files) "
+                           "order by function, file, caller, type, parameter, key, value;"):
+        add_rows(hashes, ("call", row[2], row[0] if row[3] else 0), row[:2] + row[4:])
+
+    con.close()
+    return {k: v.hexdigest() for k, v in hashes.items()}
+
+def affected_files(changed, id_to_path):
+    con = sqlite3.connect(db_file)
+    ids = set()
+    for kind, function, file in changed:
+        if kind == "ret":
+            # Static functions can only be called from the same file.
+            if file:
+                ids.add(file)
+                continue
+            ptrs = [function] + [r[0] for r in con.execute(
+                "select distinct ptr from function_ptr where function = ?;", (function,))]
+            for ptr in ptrs:
+                ids.update(r[0] for r in con.execute(
+                    "select distinct file from caller_info where function = ?;", (ptr,)))
+        else:
+            if file:
+                ids.add(file)
+                continue
+            ids.update(r[0] for r in con.execute(
+                "select distinct file from return_states where function = ? and static = 0;",
+                (function,)))
+    con.close()
+    return set(id_to_path[i] for i in ids if i in id_to_path)
+
+def analyze_one(cmd, file, out):
+    cmd = cmd.replace("{file}", file).replace("{out}", out)
+    res = subprocess.run(cmd, shell=True, stdout=subprocess.DEVNULL,
+                         stderr=subprocess.DEVNULL)
+    if res.returncode:
+        print("warning: '%s' failed" % cmd, file=sys.stderr)
+
+def analyze(args, files, tmp_dir):
+    outs = []
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        for i, file in enumerate(sorted(files)):
+            out = os.path.join(tmp_dir, "%d.smatch" % i)
+            outs.append(out)
+            pool.submit(analyze_one, args.cmd, file, out)
+
+    info_file = os.path.join(tmp_dir, "info.txt")
+    with open(info_file, "w") as info:
+        for out in outs:
+            if os.path.exists(out):
+                with open(out, errors="replace") as f:
+                    info.write(f.read())
+                os.remove(out)
+    return info_file
+
+def reload(args, info_file):
+    subprocess.run([os.path.join(data_dir, "db", "reload_partial.sh"),
+                    "-p=%s" % args.project, info_file], check=True,
+                   stdout=subprocess.DEVNULL)
+
+def main():
+    args = usage_args()
+
+    if not os.path.exists(db_file):
+        print("%s not found.  Build it with build_kernel_data.sh first." % db_file)
+        sys.exit(1)
+
+    id_to_path = file_ids(all_c_files())
+    path_to_id = {v: k for k, v in id_to_path.items()}
+
+    work = set(f for f in args.files if f.endswith(".c") and os.path.exists(f))
+    total = 0
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        for nr in range(1, args.max_passes + 1):
+            if not work:
+                break
+            before = summaries(work, path_to_id)
+            reload(args, analyze(args, work, tmp_dir))
+            after = summaries(work, path_to_id)
+
+            changed = set(k for k in before.keys() | after.keys()
+                          if before.get(k) != after.get(k))
+            total += len(work)
+            print("pass %d: analyzed %d files, %d summaries changed" %
+                  (nr, len(work), len(changed)))
+            work = affected_files(changed, id_to_path)
+
+    if work:
+        print("warning: still not converged after %d passes" % args.max_passes)
+        sys.exit(1)
+    print("done: analyzed %d files" % total)
+
+if __name__ == "__main__":
+    main()
@@ -15,6 +15,7 @@ function usage {
     echo "	--target {TARGET} : specify build target, default: $TARGET"
     echo "	--log {FILE}      : Output compile log to file, default is: $LOG"
     echo "	--wlog {FILE}     : Output warnings to file, default is: $WLOG"
+    echo "	--shards          : with --info save the SQL to SQLite shards in {WLOG}.shards/"
     echo "	--help            : Show this usage"
     exit 1
 }
@@ -36,6 +37,9 @@ while true ; do
 	shift
 	WLOG="$1"
 	shift
+    elif [[ "$1" == "--shards" ]] ; then
+	SHARDS=1
+	shift
     elif [[ "$1" == "--help" ]] ; then
 	usage
     else
@@ -48,6 +52,13 @@ if echo "$*" | grep -q info ; then
     INFO=1
 fi
 
+SHARD_PARAM=""
+if [[ $INFO -eq 1 && -n "$SHARDS" ]] ; then
+    rm -rf "$WLOG.shards"
+    mkdir "$WLOG.shards"
+    SHARD_PARAM="--info-shard=$(realpath "$WLOG.shards")"
+fi
+
 # receive parameters from environment, which override
 [ -z "${SMATCH_ENV_TARGET:-}" ] || TARGET="$SMATCH_ENV_TARGET"
 [ -z "${SMATCH_ENV_BUILD_PARAM:-}" ] || BUILD_PARAM="$SMATCH_ENV_BUILD_PARAM"
@@ -77,7 +88,7 @@ make $KERNEL_ARCH $KERNEL_CROSS_COMPILE $KERNEL_O clean
 find -name \*.c.smatch -exec rm \{\} \;
 find -name \*.c.smatch.sql -exec rm \{\} \;
 find -name \*.c.smatch.caller_info -exec rm \{\} \;
-make $KERNEL_ARCH $KERNEL_CROSS_COMPILE $KERNEL_O -j${NR_CPU} $ENDIAN -k CHECK="$CMD -p=kernel --file-output --succeed $*" \
+make $KERNEL_ARCH $KERNEL_CROSS_COMPILE $KERNEL_O -j${NR_CPU} $ENDIAN -k CHECK="$CMD -p=kernel --file-output --succeed $SHARD_PARAM $*" \
 	C=1 $BUILD_PARAM $TARGET 2>&1 | tee $LOG
 BUILD_STATUS=${PIPESTATUS[0]}
 find -name \*.c.smatch -exec cat \{\} \; -exec rm \{\} \; > $WLOG
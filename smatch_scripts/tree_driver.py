@@ -0,0 +1,261 @@
+#!/usr/bin/python3
+
+# Copyright (C) 2026 Oracle.
+#
+# Licensed under the Open Software License version 1.1
+
+# Run smatch over a whole tree without going through make.
+#
+# With test_kernel.sh the files are checked in Makefile order so the slowest
+# ones are often started last and the build ends with most of the CPUs
+# idle.  This script takes the list of files from a compile_commands.json or
+# from the output of a make dry run and starts the most expensive files
+# first.  The cost of a file is how long it took the last time this script
+# ran (saved in smatch_costs.json), or else the sum of the FUNC_TIME
+# entries in smatch_db.sqlite, or else a guess based on the file size.
+#
+# The workers take the next file from a shared queue as soon as they are
+# done so one slow file doesn't hold up the rest.  The output of each file
+# is appended to the warnings file as soon as it finishes.
+#
+# For the kernel, build the list of files with a dry run where CHECK is a
+# marker which is easy to find:
+#   make -n -k C=1 CHECK=SMATCH_CHECK > dry_run.txt
+#   tree_driver.py --make-dry-run dry_run.txt -- -p=kernel --succeed
+#
+# Everything after the "--" is passed to smatch.  With --info the SQL is
+# printed to stdout so the warnings file can be passed to create_db.sh.
+
+import argparse
+import json
+import os
+import queue
+import shlex
+import sqlite3
+import subprocess
+import sys
+import threading
+import time
+
+script_dir = os.path.dirname(os.path.abspath(sys.argv[0]))
+data_dir = os.path.join(script_dir, "..", "smatch_data")
+FUNC_TIME = 1047
+
+def usage_args():
+    parser = argparse.ArgumentParser(
+        description="Check a whole tree with smatch, most expensive files first.")
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("--compile-commands", metavar="FILE",
+                     help="read the files and flags from a compile_commands.json")
+    src.add_argument("--make-dry-run", metavar="FILE",
+                     help="read the check commands from the output of make -n")
+    parser.add_argument("--marker", default="SMATCH_CHECK",
+                        help="the CHECK= command used for the dry run")
+    parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count())
+    parser.add_argument("--smatch", default=os.path.join(script_dir, "..", "smatch"))
+    parser.add_argument("--costs", default="smatch_costs.json",
+                        help="file where the cost of each file is saved")
+    parser.add_argument("--db", default="smatch_db.sqlite")
+    parser.add_argument("--wlog", default="smatch_warns.txt")
+    parser.add_argument("--log", default="smatch_compile.warns")
+    parser.add_argument("smatch_args", nargs="*")
+    return parser.parse_args()
+
+class Job:
+    def __init__(self, directory, args, path):
+        self.directory = directory
+        self.args = args
+        self.path = path
+        self.name = os.path.relpath(os.path.join(directory, path))
+        self.cost = None
+
+# Only keep the compiler flags which change how the code is parsed.
+def filter_cc_args(args):
+    ret = []
+    with_arg = ("-D", "-U", "-I", "-include", "-imacros", "-isystem",
+                "-idirafter", "-iquote")
+    i = 1
+    while i < len(args):
+        arg = args[i]
+        if arg in with_arg and i + 1 < len(args):
+            ret += [arg, args[i + 1]]
+            i += 2
+            continue
+        if arg.startswith(("-D", "-U", "-I", "-std=", "-m", "-f")) or \
+           arg == "-nostdinc":
+            ret.append(arg)
+        elif arg in ("-o", "-MF", "-MT", "-MQ"):
+            i += 1
+        i += 1
+    return ret
+
+def read_compile_commands(filename):
+    jobs = []
+    with open(filename) as f:
+        for entry in json.load(f):
+            path = entry["file"]
+            if not path.endswith(".c"):
+                continue
+            if "arguments" in entry:
+                args = entry["arguments"]
+            else:
+                args = shlex.split(entry["command"])
+            args = [a for a in args if a != path]
+            jobs.append(Job(entry.get("directory", "."), filter_cc_args(args), path))
+    return jobs
+
+def split_commands(line):
+    lex = shlex.shlex(line, posix=True, punctuation_chars=True)
+    lex.whitespace_split = True
+    cmd = []
+    try:
+        for tok in lex:
+            if tok and all(c in ";&|" for c in tok):
+                yield cmd
+                cmd = []
+            else:
+                cmd.append(tok)
+    except ValueError:
+        pass
+    yield cmd
+
+def read_make_dry_run(filename, marker):
+    jobs = []
+    directory = "."
+    with open(filename, errors="replace") as f:
+        for line in f:
+            if "Entering directory" in line:
+                directory = line.split("Entering directory")[1].strip(" '`\n")
+                continue
+            if marker not in line:
+                continue
+            for cmd in split_commands(line):
+                if marker not in cmd:
+                    continue
+                cmd = cmd[cmd.index(marker) + 1:]
+                files = [a for a in cmd if a.endswith(".c")]
+                if not files:
+                    continue
+                path = files[-1]
+                args = [a for a in cmd if a != path]
+                jobs.append(Job(directory, args, path))
+    return jobs
+
+def load_costs(filename):
+    try:
+        with open(filename) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+def save_costs(filename, costs):
+    tmp = filename + ".tmp"
+    with open(tmp, "w") as f:
+        json.dump(costs, f, indent=0, sort_keys=True)
+    os.replace(tmp, filename)
+
+# The file column in the DB is the sm_hash of the file name.
+def db_costs(db_file, jobs):
+    if not os.path.exists(db_file):
+        return {}
+    sm_hash = os.path.join(data_dir, "db", "sm_hash")
+    names = [job.name for job in jobs]
+    ids = {}
+    try:
+        for i in range(0, len(names), 1000):
+            chunk = names[i:i + 1000]
+            out = subprocess.run([sm_hash] + chunk, capture_output=True,
+                                 text=True, check=True).stdout.split()
+            for name, hash in zip(chunk, out):
+                ids[int(hash)] = name
+        con = sqlite3.connect(db_file)
+        rows = con.execute("select file, sum(cast(value as integer)) from return_implies "
+                           "where type = ? group by file;", (FUNC_TIME,)).fetchall()
+        con.close()
+    except (OSError, subprocess.CalledProcessError, sqlite3.Error):
+        return {}
+    return {ids[f]: t for f, t in rows if f in ids and t}
+
+def set_costs(jobs, costs, from_db):
+    known_cost = 0
+    known_size = 0
+    for job in jobs:
+        job.cost = costs.get(job.name, from_db.get(job.name))
+        try:
+            job.size = os.path.getsize(os.path.join(job.directory, job.path))
+        except OSError:
+            job.size = 0
+        if job.cost is not None:
+            known_cost += job.cost
+            known_size += job.size
+    rate = known_cost / known_size if known_cost and known_size else 1e-5
+    for job in jobs:
+        if job.cost is None:
+            job.cost = job.size * rate
+
+def run_jobs(args, jobs):
+    work = queue.Queue()
+    for job in sorted(jobs, key=lambda j: j.cost, reverse=True):
+        work.put(job)
+
+    lock = threading.Lock()
+    results = {}
+    failed = []
+    wlog = open(args.wlog, "w")
+    log = open(args.log, "w")
+
+    def worker():
+        while True:
+            try:
+                job = work.get_nowait()
+            except queue.Empty:
+                return
+            cmd = [os.path.abspath(args.smatch)] + args.smatch_args + job.args + [job.path]
+            start = time.monotonic()
+            res = subprocess.run(cmd, cwd=job.directory, capture_output=True)
+            elapsed = time.monotonic() - start
+            with lock:
+                wlog.write(res.stdout.decode(errors="replace"))
+                wlog.flush()
+                log.write(res.stderr.decode(errors="replace"))
+                log.flush()
+                results[job.name] = elapsed
+                if res.returncode:
+                    failed.append(job.name)
+
+    threads = [threading.Thread(target=worker) for i in range(max(args.jobs, 1))]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    wlog.close()
+    log.close()
+    return results, failed
+
+def main():
+    args = usage_args()
+
+    if args.compile_commands:
+        jobs = read_compile_commands(args.compile_commands)
+    else:
+        jobs = read_make_dry_run(args.make_dry_run, args.marker)
+    if not jobs:
+        print("no files found")
+        sys.exit(1)
+
+    costs = load_costs(args.costs)
+    set_costs(jobs, costs, db_costs(args.db, jobs))
+
+    start = time.monotonic()
+    results, failed = run_jobs(args, jobs)
+    costs.update(results)
+    save_costs(args.costs, costs)
+
+    print("Done. Checked %d files in %d seconds.  The warnings are saved to %s" %
+          (len(results), time.monotonic() - start, args.wlog))
+    if failed:
+        print("%d files failed, see %s" % (len(failed), args.log))
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
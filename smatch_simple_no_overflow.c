@@ -243,7 +243,7 @@ static void struct_member_callback(struct expression *call, int param, char *pri
 	struct smatch_state *state;
 	struct smatch_state *extra_state;
 
-	if (strcmp(sm->state->name, "") == 0)
+	if (strcmp(show_state(sm->state), "") == 0)
 		return;
 
 	extra_state = get_state(SMATCH_EXTRA, sm->name, sm->sym);
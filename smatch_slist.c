@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include "smatch.h"
 #include "smatch_slist.h"
+#include "smatch_extra.h"
 
 #undef CHECKORDER
 
@@ -141,11 +142,13 @@ int cmp_tracker(const struct sm_state *a, const struct sm_state *b)
 	if (a->owner > b->owner)
 		return 1;
 
-	ret = strcmp(a->name, b->name);
-	if (ret < 0)
-		return -1;
-	if (ret > 0)
-		return 1;
+	/* names are interned so they are either the same pointer or not equal */
+	if (a->name != b->name) {
+		ret = sname_order(a->name) < sname_order(b->name) ? -1 : 1;
+		if (option_debug_sname)
+			check_sname_order(a->name, b->name, ret);
+		return ret;
+	}
 
 	if (!b->sym && a->sym)
 		return -1;
@@ -215,11 +218,13 @@ static int cmp_possible_sm(const struct sm_state *a, const struct sm_state *b, i
 			if (!a->merged)
 				return 1;
 		}
+		if (estate_names_equal(a->state, b->state))
+			return 0;
 	}
-	if (!a->state->name || !b->state->name)
+	if (!show_state(a->state) || !show_state(b->state))
 		return 0;
 
-	return strcmp(a->state->name, b->state->name);
+	return strcmp(show_state(a->state), show_state(b->state));
 }
 
 struct sm_state *alloc_sm_state(int owner, const char *name,
@@ -228,8 +233,10 @@ struct sm_state *alloc_sm_state(int owner, const char *name,
 	struct sm_state *sm_state = __alloc_sm_state(0);
 
 	sm_state_counter++;
+	if (option_profile_checks)
+		__profile_sm_state(owner);
 
-	sm_state->name = alloc_sname(name);
+	sm_state->name = intern_sname(name);
 	sm_state->owner = owner;
 	sm_state->sym = sym;
 	sm_state->state = state;
@@ -267,7 +274,7 @@ void add_possible_sm(struct sm_state *to, struct sm_state *new)
 	int preserve = 1;
 	int cmp;
 
-	if (too_many_possible(to))
+	if (too_many_possible(to) || low_on_memory())
 		preserve = 0;
 
 	FOR_EACH_PTR(to->possible, tmp) {
@@ -320,20 +327,86 @@ char *alloc_sname(const char *str)
 	return tmp;
 }
 
+/*
+ * The memory governor.  It counts the bytes held by every allocator plus
+ * the stree nodes, minus what was already held when the function started,
+ * and compares that against --mem-budget.  The tokens, symbols and
+ * expressions for the file stay around until the end so leaving them out
+ * means the budget only depends on the current function.  As we use up
+ * the budget it gives up on things in stages:
+ *
+ * MEM_TRIM_HISTORY:     stop preserving leaf states in the ->possible lists
+ *                       and only do fast math.
+ * MEM_NO_IMPLICATIONS:  turn off implications.
+ * MEM_NO_MERGES:        stop merging states and give up on the function.
+ *
+ * The stage only goes up during a function.  It is reset when the
+ * function's sm_states are freed.
+ */
+unsigned long option_mem_budget = 1024;  /* in MB */
+static enum mem_stage mem_stage;
+
+static const char *mem_stage_name(enum mem_stage stage)
+{
+	switch (stage) {
+	case MEM_OK:
+		return "ok";
+	case MEM_TRIM_HISTORY:
+		return "trim_history";
+	case MEM_NO_IMPLICATIONS:
+		return "no_implications";
+	case MEM_NO_MERGES:
+		return "no_merges";
+	}
+	return "unknown";
+}
+
+static unsigned long func_mem_base;
+static unsigned long func_mem_peak;
+
+unsigned long get_mem_used(void)
+{
+	unsigned long used;
+
+	used = allocated_blob_bytes + avl_node_count * sizeof(AvlNode);
+	used = used > func_mem_base ? used - func_mem_base : 0;
+	if (used > func_mem_peak)
+		func_mem_peak = used;
+	return used;
+}
+
+unsigned long get_func_mem_peak(void)
+{
+	get_mem_used();
+	return func_mem_peak;
+}
+
+void reset_func_mem_peak(void)
+{
+	func_mem_base = allocated_blob_bytes + avl_node_count * sizeof(AvlNode);
+	func_mem_peak = 0;
+}
+
 static struct symbol *oom_func;
 static int oom_limit = 3000000;  /* Start with a 3GB limit */
-int out_of_memory(void)
+static unsigned long rss_checked_at;
+
+static bool rss_too_high(void)
 {
+	unsigned long used;
+
 	if (oom_func)
-		return 1;
+		return true;
 
 	/*
-	 * I decided to use 50M here based on trial and error.
-	 * It works out OK for the kernel and so it should work
-	 * for most other projects as well.
+	 * Reading statm is slow so only do it when we have allocated
+	 * another 16MB since the last time we checked.
 	 */
-	if (sm_state_counter * sizeof(struct sm_state) >= 100000000)
-		return 1;
+	used = get_mem_used();
+	if (used < rss_checked_at + 16 * 1024 * 1024 &&
+	    used + 16 * 1024 * 1024 > rss_checked_at)
+		return false;
+	rss_checked_at = used;
 
 	/*
 	 * We're reading from statm to figure out how much memory we
@@ -350,17 +423,44 @@ int out_of_memory(void)
 		final_pass++;
 		sm_perror("OOM: %luKb sm_state_count = %d", get_mem_kb(), sm_state_counter);
 		final_pass--;
-		return 1;
+		return true;
 	}
+	return false;
+}
 
-	return 0;
+enum mem_stage get_mem_stage(void)
+{
+	unsigned long budget = option_mem_budget * 1024 * 1024;
+	unsigned long used = get_mem_used();
+	enum mem_stage stage = MEM_OK;
+
+	if (rss_too_high() || used >= budget)
+		stage = MEM_NO_MERGES;
+	else if (used >= budget / 4 * 3)
+		stage = MEM_NO_IMPLICATIONS;
+	else if (used >= budget / 2)
+		stage = MEM_TRIM_HISTORY;
+
+	if (stage <= mem_stage)
+		return mem_stage;
+
+	final_pass++;
+	sm_msg("mem_governor: stage=%s prev=%s used=%luKb budget=%luKb sm_states=%d",
+	       mem_stage_name(stage), mem_stage_name(mem_stage),
+	       used / 1024, budget / 1024, sm_state_counter);
+	final_pass--;
+	mem_stage = stage;
+	return mem_stage;
+}
+
+int out_of_memory(void)
+{
+	return get_mem_stage() >= MEM_NO_MERGES;
 }
 
 int low_on_memory(void)
 {
-	if (sm_state_counter * sizeof(struct sm_state) >= 25000000)
-		return 1;
-	return 0;
+	return get_mem_stage() >= MEM_TRIM_HISTORY;
 }
 
 static void free_sm_state(struct sm_state *sm)
@@ -391,6 +491,7 @@ void free_every_single_sm_state(void)
 	struct allocator_struct *desc = &sm_state_allocator;
 	struct allocation_blob *blob = desc->blobs;
 
+	allocated_blob_bytes -= desc->total_bytes;
 	desc->blobs = NULL;
 	desc->allocations = 0;
 	desc->total_bytes = 0;
@@ -403,10 +504,12 @@ void free_every_single_sm_state(void)
 		blob = next;
 	}
 	clear_sname_alloc();
+	clear_interned_states();
 	clear_smatch_state_alloc();
 
 	free_stack_and_strees(&all_pools);
 	sm_state_counter = 0;
+	mem_stage = MEM_OK;
 	if (oom_func) {
 		oom_limit += 100000;
 		oom_func = NULL;
@@ -505,6 +608,7 @@ struct sm_state *merge_sm_states(struct sm_state *one, struct sm_state *two)
 		return one;
 	}
 	warned = 0;
+	add_work(1);
 	s = merge_states(one->owner, one->name, one->sym, one->state, two->state);
 	result = alloc_state_no_name(one->owner, one->name, one->sym, s);
 	result->merged = 1;
@@ -558,11 +662,12 @@ struct sm_state *get_sm_state_stree(struct stree *stree, int owner, const char *
 {
 	struct tracker tracker = {
 		.owner = owner,
-		.name = (char *)name,
+		.name = (char *)lookup_sname(name),
 		.sym = sym,
 	};
 
-	if (!name)
+	/* If the name was never interned then nothing can be tracking it. */
+	if (!tracker.name)
 		return NULL;
 
 	return avl_lookup(stree, (struct sm_state *)&tracker);
@@ -612,12 +717,11 @@ void set_state_stree_perm(struct stree **stree, int owner, const char *name,
 {
 	struct sm_state *sm;
 
-	sm = malloc(sizeof(*sm) + strlen(name) + 1);
+	sm = malloc(sizeof(*sm));
 	memset(sm, 0, sizeof(*sm));
 	sm->line = get_lineno();
 	sm->owner = owner;
-	sm->name = (char *)(sm + 1);
-	strcpy((char *)sm->name, name);
+	sm->name = intern_sname(name);
 	sm->sym = sym;
 	sm->state = state;
 
@@ -629,10 +733,13 @@ void delete_state_stree(struct stree **stree, int owner, const char *name,
 {
 	struct tracker tracker = {
 		.owner = owner,
-		.name = (char *)name,
+		.name = (char *)lookup_sname(name),
 		.sym = sym,
 	};
 
+	if (!tracker.name)
+		return;
+
 	avl_remove(stree, (struct sm_state *)&tracker);
 }
 
@@ -841,6 +948,20 @@ static void clone_pool_havers_stree(struct stree **stree)
 }
 
 int __stree_id;
+unsigned long __merge_reused_cnt;
+unsigned long __merge_merged_cnt;
+
+/*
+ * The implication code caches which pools an sm_state's history splits into
+ * so it has to know when a ->pool changes.
+ */
+static void set_pool(struct sm_state *sm, struct stree *pool)
+{
+	if (sm->pool == pool)
+		return;
+	sm->pool = pool;
+	invalidate_pool_cache();
+}
 
 /*
  * merge_slist() is called whenever paths merge, such as after
@@ -854,6 +975,7 @@ static void __merge_stree(struct stree **to, struct stree *stree, int add_pool)
 	AvlIter one_iter;
 	AvlIter two_iter;
 	struct sm_state *one, *two, *res;
+	unsigned long merged;
 
 	if (out_of_memory())
 		return;
@@ -890,6 +1012,15 @@ static void __merge_stree(struct stree **to, struct stree *stree, int add_pool)
 	push_stree(&all_pools, implied_one);
 	push_stree(&all_pools, implied_two);
 
+	/*
+	 * Both strees have the same trackers now.  Start with everything from
+	 * implied_one and only replace the states which are different.  The
+	 * nodes are shared so if both iterators are on the same node then the
+	 * rest of that subtree is the same as well and we can skip it.
+	 */
+	results = clone_stree_nodes(implied_one);
+	merged = 0;
+
 	avl_iter_begin(&one_iter, implied_one, FORWARD);
 	avl_iter_begin(&two_iter, implied_two, FORWARD);
 
@@ -897,31 +1028,38 @@ static void __merge_stree(struct stree **to, struct stree *stree, int add_pool)
 		if (!one_iter.sm || !two_iter.sm)
 			break;
 
+		if (one_iter.node == two_iter.node) {
+			avl_iter_skip(&one_iter);
+			avl_iter_skip(&two_iter);
+			continue;
+		}
+
 		one = one_iter.sm;
 		two = two_iter.sm;
 
-		if (one == two) {
-			avl_insert(&results, one);
+		if (one == two)
 			goto next;
-		}
 
 		if (add_pool) {
-			one->pool = implied_one;
-			if (implied_one->base_stree)
-				one->pool = implied_one->base_stree;
-			two->pool = implied_two;
-			if (implied_two->base_stree)
-				two->pool = implied_two->base_stree;
+			set_pool(one, implied_one->base_stree ?: implied_one);
+			set_pool(two, implied_two->base_stree ?: implied_two);
 		}
 		res = merge_sm_states(one, two);
 		add_possible_sm(res, one);
 		add_possible_sm(res, two);
 		avl_insert(&results, res);
+		merged++;
 next:
 		avl_iter_next(&one_iter);
 		avl_iter_next(&two_iter);
 	}
 
+	__merge_merged_cnt += merged;
+	__merge_reused_cnt += stree_count(results) - merged;
+
+	if (!stree_count(results))
+		free_stree(&results);
+
 	free_stree(to);
 	*to = results;
 }
@@ -14,8 +14,26 @@ DECLARE_ALLOCATOR(named_stree);
 DECLARE_PTR_LIST(named_stree_stack, struct named_stree);
 
 
+struct sname {
+	unsigned long long order;
+	char str[];
+};
+
+static inline unsigned long long sname_order(const char *name)
+{
+	return ((struct sname *)(name - offsetof(struct sname, str)))->order;
+}
+
+extern int option_debug_sname;
+const char *intern_sname(const char *str);
+const char *lookup_sname(const char *str);
+void check_sname_order(const char *a, const char *b, int cmp);
+void show_sname_stats(void);
+
 extern struct state_list_stack *implied_pools;
 extern int __stree_id;
+extern unsigned long __merge_reused_cnt;
+extern unsigned long __merge_merged_cnt;
 extern int sm_state_counter;
 
 const char *show_sm(struct sm_state *sm);
@@ -74,6 +92,17 @@ struct sm_state *get_sm_state_stree_stack(struct stree_stack *stack,
 struct smatch_state *get_state_stree_stack(struct stree_stack *stack, int owner,
 				const char *name, struct symbol *sym);
 
+enum mem_stage {
+	MEM_OK,
+	MEM_TRIM_HISTORY,
+	MEM_NO_IMPLICATIONS,
+	MEM_NO_MERGES,
+};
+extern unsigned long option_mem_budget;
+unsigned long get_mem_used(void);
+unsigned long get_func_mem_peak(void);
+void reset_func_mem_peak(void);
+enum mem_stage get_mem_stage(void);
 int out_of_memory(void);
 int low_on_memory(void);
 void merge_stree(struct stree **to, struct stree *stree);
@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2026 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * Every sm_state name is interned here.  Two sm_states track the same
+ * variable if and only if their ->name pointers are the same, so the stree
+ * code never has to call strcmp().
+ *
+ * The strees are sorted by name and we want to keep the same ordering as
+ * strcmp() so that the output doesn't change.  Each interned name has an
+ * ->order label and the labels are sorted the same way as the strings.
+ * When a new name is added it gets a label half way between its neighbours.
+ * If there is no gap left then all the labels are re-numbered.  The labels
+ * are only ever compared against each other so re-numbering them is safe.
+ *
+ */
+
+#include <stdlib.h>
+#include "smatch.h"
+#include "smatch_slist.h"
+#include "smatch_function_hashtable.h"
+
+__DO_ALLOCATOR(struct sname, sizeof(struct sname), __alignof__(struct sname),
+	       "interned names", interned_sname);
+
+DEFINE_HASHTABLE_INSERT(insert_sname, char, struct sname);
+DEFINE_HASHTABLE_SEARCH(search_sname, char, struct sname);
+static struct hashtable *sname_table;
+
+/*
+ * The interned names are kept in sorted order in a list of blocks.  The
+ * blocks make it cheap to find the neighbours of a new name without
+ * having to memmove() the whole array on every insert.
+ */
+#define SNAME_BLOCK 256
+struct sname_block {
+	int nr;
+	struct sname *names[SNAME_BLOCK];
+};
+
+static struct sname_block **blocks;
+static int nr_blocks;
+static int max_blocks;
+static int nr_snames;
+static int nr_relabels;
+
+#define ORDER_STEP (1ULL << 32)
+
+int option_debug_sname;
+
+static struct sname *first_sname(int block)
+{
+	return blocks[block]->names[0];
+}
+
+static struct sname *last_sname(int block)
+{
+	return blocks[block]->names[blocks[block]->nr - 1];
+}
+
+static void relabel_all(void)
+{
+	unsigned long long order, step;
+	int i, j;
+
+	nr_relabels++;
+
+	step = ~0ULL / (nr_snames + 2);
+	order = step;
+	for (i = 0; i < nr_blocks; i++) {
+		for (j = 0; j < blocks[i]->nr; j++) {
+			blocks[i]->names[j]->order = order;
+			order += step;
+		}
+	}
+}
+
+static void new_block(int idx)
+{
+	if (nr_blocks == max_blocks) {
+		max_blocks = max_blocks ? max_blocks * 2 : 16;
+		blocks = realloc(blocks, max_blocks * sizeof(*blocks));
+		if (!blocks)
+			sm_fatal("%s: out of memory", __func__);
+	}
+	memmove(&blocks[idx + 1], &blocks[idx], (nr_blocks - idx) * sizeof(*blocks));
+	blocks[idx] = calloc(1, sizeof(struct sname_block));
+	if (!blocks[idx])
+		sm_fatal("%s: out of memory", __func__);
+	nr_blocks++;
+}
+
+static void split_block(int idx)
+{
+	struct sname_block *old;
+	int half;
+
+	new_block(idx + 1);
+	old = blocks[idx];
+	half = old->nr / 2;
+	memcpy(blocks[idx + 1]->names, &old->names[half],
+	       (old->nr - half) * sizeof(struct sname *));
+	blocks[idx + 1]->nr = old->nr - half;
+	old->nr = half;
+}
+
+static int find_block(const char *str)
+{
+	int lo = 0, hi = nr_blocks - 1, mid;
+
+	/* Find the first block whose last name sorts after str. */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (strcmp(last_sname(mid)->str, str) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static int find_slot(struct sname_block *block, const char *str)
+{
+	int lo = 0, hi = block->nr, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (strcmp(block->names[mid]->str, str) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static void add_sorted(struct sname *new)
+{
+	struct sname_block *block;
+	struct sname *prev, *next;
+	unsigned long long lo, hi;
+	int b, slot;
+
+	if (!nr_blocks)
+		new_block(0);
+
+	b = find_block(new->str);
+	if (blocks[b]->nr == SNAME_BLOCK) {
+		split_block(b);
+		if (strcmp(last_sname(b)->str, new->str) < 0)
+			b++;
+	}
+	block = blocks[b];
+	slot = find_slot(block, new->str);
+	memmove(&block->names[slot + 1], &block->names[slot],
+		(block->nr - slot) * sizeof(struct sname *));
+	block->names[slot] = new;
+	block->nr++;
+	nr_snames++;
+
+	prev = NULL;
+	if (slot > 0)
+		prev = block->names[slot - 1];
+	else if (b > 0)
+		prev = last_sname(b - 1);
+	next = NULL;
+	if (slot + 1 < block->nr)
+		next = block->names[slot + 1];
+	else if (b + 1 < nr_blocks)
+		next = first_sname(b + 1);
+
+	lo = prev ? prev->order : 0;
+	hi = next ? next->order : ~0ULL;
+
+	/*
+	 * Appending to either end is the common case so leave a large fixed
+	 * gap there instead of cutting the remaining space in half each time.
+	 */
+	if (!next && hi - lo > ORDER_STEP)
+		new->order = lo + ORDER_STEP;
+	else if (!prev && hi - lo > ORDER_STEP)
+		new->order = hi - ORDER_STEP;
+	else if (hi - lo >= 2)
+		new->order = lo + (hi - lo) / 2;
+	else
+		relabel_all();
+}
+
+const char *lookup_sname(const char *str)
+{
+	struct sname *sname;
+
+	if (!str || !sname_table)
+		return NULL;
+	sname = search_sname(sname_table, (char *)str);
+	if (!sname)
+		return NULL;
+	return sname->str;
+}
+
+const char *intern_sname(const char *str)
+{
+	struct sname *sname;
+	int len;
+
+	if (!str)
+		return NULL;
+	if (!sname_table)
+		sname_table = create_function_hashtable(4096);
+
+	sname = search_sname(sname_table, (char *)str);
+	if (sname)
+		return sname->str;
+
+	len = strlen(str) + 1;
+	sname = __alloc_interned_sname(len);
+	memcpy(sname->str, str, len);
+	add_sorted(sname);
+	insert_sname(sname_table, sname->str, sname);
+	return sname->str;
+}
+
+void check_sname_order(const char *a, const char *b, int cmp)
+{
+	int ret;
+
+	ret = strcmp(a, b);
+	if (ret < 0)
+		ret = -1;
+	else if (ret > 0)
+		ret = 1;
+
+	if ((ret == 0) != (a == b) || ret != cmp)
+		sm_fatal("interned name order mismatch: '%s' vs '%s' (strcmp = %d interned = %d)",
+			 a, b, ret, cmp);
+}
+
+void show_sname_stats(void)
+{
+	sm_msg("interned names: %d blocks: %d relabels: %d",
+	       nr_snames, nr_blocks, nr_relabels);
+}
@@ -84,7 +84,7 @@ static struct smatch_state *alloc_ssa_copy(struct sm_state *sm)
 		return sm->state;
 
 	state = __alloc_smatch_state(0);
-	state->name = alloc_sname(sm->state->name);
+	state->name = alloc_sname(show_state(sm->state));
 	return state;
 }
 
@@ -162,7 +162,7 @@ static void match_assign(struct expression *expr)
 	 */
 	clone        = clone_sm(orig);
 	clone->state = alloc_ssa_copy(orig);
-	clone->name  = alloc_sname(left_name);
+	clone->name  = intern_sname(left_name);
 	clone->sym   = left_sym;
 	__set_sm(clone);
 
@@ -192,7 +192,7 @@ void set_ssa_state(int owner, const char *name, struct symbol *sym,
 	}
 	if (!sm)
 		return;
-	set_state(owner, sm->state->name, NULL, state);
+	set_state(owner, show_state(sm->state), NULL, state);
 }
 
 void update_ssa_state(int owner, const char *name, struct symbol *sym,
@@ -209,7 +209,7 @@ void update_ssa_sm(int owner, struct sm_state *ssa_sm, struct smatch_state *stat
 		if (tmp->state == &merged ||
 		    tmp->state == &undefined)
 			continue;
-		set_state(owner, tmp->state->name, NULL, state);
+		set_state(owner, show_state(tmp->state), NULL, state);
 	} END_FOR_EACH_PTR(tmp);
 }
 
@@ -239,7 +239,7 @@ struct sm_state *get_ssa_sm_state(int owner, const char *name, struct symbol *sy
 		if (tmp->state == &merged ||
 		    tmp->state == &undefined)
 			continue;
-		owner_sm = get_sm_state(owner, tmp->state->name, NULL);
+		owner_sm = get_sm_state(owner, show_state(tmp->state), NULL);
 		if (owner_sm) {
 			if (!ret)
 				ret = clone_sm(owner_sm);
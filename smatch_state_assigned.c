@@ -60,7 +60,7 @@ static void call_ssa_hooks(struct sm_state *ssa_sm, struct sm_state *sm, struct
 		if (tmp->state == &merged ||
 		    tmp->state == &undefined)
 			continue;
-		if (strcmp(tmp->state->name, sm->name) == 0)
+		if (strcmp(show_state(tmp->state), sm->name) == 0)
 			ssa_hooks[sm->owner](sm, expr);
 	} END_FOR_EACH_PTR(tmp);
 
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 Oracle.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see http://www.gnu.org/copyleft/gpl.txt
+ */
+
+/*
+ * A hash table of smatch_states which are never changed after they are
+ * created.  The owner looks up a state by its payload and if an identical
+ * one already exists it gets that pointer back instead.  When the same state
+ * is built on different paths the sm_states end up pointing to the same
+ * smatch_state, so merge_states() can take the state1 == state2 shortcut
+ * instead of calling the merge hook and allocating another copy.
+ *
+ * The owner does the hashing and says when two states are the same.  The
+ * states come from the per function allocators, so the table is emptied
+ * in free_every_single_sm_state().
+ *
+ */
+
+#include "smatch.h"
+
+struct intern_slot {
+	int owner;
+	unsigned int hash;
+	struct smatch_state *state;
+};
+
+static struct intern_slot *table;
+static int table_size;
+static int table_used;
+static unsigned long intern_added, intern_hits;
+
+static struct intern_slot *find_slot(int owner, unsigned int hash,
+				     struct smatch_state *state,
+				     bool (*same)(struct smatch_state *a, struct smatch_state *b))
+{
+	struct intern_slot *slot;
+	unsigned int i;
+
+	i = hash & (table_size - 1);
+	for (;;) {
+		slot = &table[i];
+		if (!slot->state)
+			return slot;
+		if (slot->owner == owner && slot->hash == hash &&
+		    (!same || same(slot->state, state)))
+			return slot;
+		i = (i + 1) & (table_size - 1);
+	}
+}
+
+static void grow_table(void)
+{
+	struct intern_slot *old = table;
+	int old_size = table_size;
+	int i;
+
+	table_size = old_size ? old_size * 2 : 1024;
+	table = calloc(table_size, sizeof(*table));
+	if (!table)
+		sm_fatal("%s: out of memory", __func__);
+
+	for (i = 0; i < old_size; i++) {
+		if (old[i].state)
+			*find_slot(old[i].owner, old[i].hash, old[i].state, NULL) = old[i];
+	}
+	free(old);
+}
+
+/*
+ * Returns the interned state which is the same as @state, or NULL.
+ */
+struct smatch_state *lookup_interned_state(int owner, unsigned int hash,
+		struct smatch_state *state,
+		bool (*same)(struct smatch_state *a, struct smatch_state *b))
+{
+	if (!table_used)
+		return NULL;
+	state = find_slot(owner, hash, state, same)->state;
+	if (state)
+		intern_hits++;
+	return state;
+}
+
+/*
+ * Adds @state to the table unless there is already one which is the same.
+ * Either way it returns the interned state.  The caller must not change
+ * @state afterwards.
+ */
+struct smatch_state *intern_state(int owner, unsigned int hash,
+		struct smatch_state *state,
+		bool (*same)(struct smatch_state *a, struct smatch_state *b))
+{
+	struct intern_slot *slot;
+
+	if ((table_used + 1) * 2 > table_size)
+		grow_table();
+
+	slot = find_slot(owner, hash, state, same);
+	if (slot->state) {
+		intern_hits++;
+		return slot->state;
+	}
+	slot->owner = owner;
+	slot->hash = hash;
+	slot->state = state;
+	table_used++;
+	intern_added++;
+	return state;
+}
+
+unsigned int hash_intern_str(unsigned int hash, const char *str)
+{
+	const unsigned char *p;
+
+	if (!str)
+		return hash_mix(hash, 0);
+	for (p = (const unsigned char *)str; *p; p++)
+		hash = (hash ^ *p) * 0x01000193U;
+	return hash_mix(hash, 0);
+}
+
+void clear_interned_states(void)
+{
+	if (table_used)
+		memset(table, 0, table_size * sizeof(*table));
+	table_used = 0;
+}
+
+void show_intern_state_stats(void)
+{
+	sm_msg("interned states: added %lu reused %lu",
+	       intern_added, intern_hits);
+}
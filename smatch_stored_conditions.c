@@ -294,9 +294,9 @@ static void filter_by_sm(struct sm_state *sm,
 	if ((*recurse_cnt)++ > RECURSE_LIMIT)
 		return;
 
-	if (strcmp(sm->state->name, "true") == 0) {
+	if (strcmp(show_state(sm->state), "true") == 0) {
 		add_ptr_list(true_stack, sm);
-	} else if (strcmp(sm->state->name, "false") == 0) {
+	} else if (strcmp(show_state(sm->state), "false") == 0) {
 		add_ptr_list(false_stack, sm);
 	}
 
@@ -387,7 +387,7 @@ static void struct_member_callback(struct expression *call, int param, char *pri
 {
 	if (sm->state == &merged)
 		return;
-	sql_insert_caller_info(call, STR_LEN, param, printed_name, sm->state->name);
+	sql_insert_caller_info(call, STR_LEN, param, printed_name, show_state(sm->state));
 }
 
 void register_strlen(int id)
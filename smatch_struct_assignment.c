@@ -461,7 +461,7 @@ static int copy_containter_states(struct expression *left, struct expression *ri
 			continue;
 		snprintf(new_name, sizeof(new_name), "%s%s", left_name, sm->name + len);
 		new_sm = clone_sm(sm);
-		new_sm->name = alloc_sname(new_name);
+		new_sm->name = intern_sname(new_name);
 		new_sm->sym = left_sym;
 		__set_sm(new_sm);
 		ret = 1;
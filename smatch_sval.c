@@ -866,14 +866,7 @@ sval_t ll_to_sval(long long val)
 	return ret;
 }
 
-static void free_svals(struct symbol *sym)
-{
-	if (__inline_fn)
-		return;
-	clear_sval_alloc();
-}
-
 void register_sval(int my_id)
 {
-	add_hook(&free_svals, AFTER_FUNC_HOOK);
+	func_scope_sval_alloc();
 }
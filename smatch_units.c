@@ -138,7 +138,7 @@ static void store_type_in_db(struct expression *expr, struct smatch_state *state
 	if (is_ignored_type(member))
 		return;
 
-	sql_insert_cache(type_info, "0x%llx, %d, '%s', '%s'", get_base_file_id(), UNITS, member, state->name);
+	sql_insert_cache(type_info, "0x%llx, %d, '%s', '%s'", get_base_file_id(), UNITS, member, show_state(state));
 }
 
 static void set_units(struct expression *expr, struct smatch_state *state)
@@ -256,6 +256,7 @@ static int db_units(void *_units, int argc, char **argv, char **azColName)
 
 static struct smatch_state *get_units_from_type(struct expression *expr)
 {
+	struct sql_bind bind = {};
 	char *member;
 	char *units = NULL;
 	struct smatch_state *ret = NULL;
@@ -270,10 +271,11 @@ static struct smatch_state *get_units_from_type(struct expression *expr)
 			return member_table[i].unit;
 	}
 
-	cache_sql(&db_units, &units, "select value from type_info where type = %d and key = '%s';",
-		  UNITS, member);
-	run_sql(&db_units, &units, "select value from type_info where type = %d and key = '%s';",
-		UNITS, member);
+	sql_bind_text(&bind, member);
+	cache_sql_bound(&db_units, &units, &bind,
+			"select value from type_info where type = %d and key = ?;", UNITS);
+	run_sql_bound(&db_units, &units, &bind,
+		      "select value from type_info where type = %d and key = ?;", UNITS);
 	if (!units)
 		return NULL;
 
@@ -492,7 +494,7 @@ static void match_call_info(struct expression *expr)
 			continue;
 //		sql_insert_cache(return_implies, "0x%llx, '%s', 0, %d, %d, %d, '%s', '%s'",
 //				 get_base_file_id(), fn_name, is_static(expr->fn), UNITS, param, "$", state->name);
-		sql_insert_caller_info(expr, UNITS, param, "$", state->name);
+		sql_insert_caller_info(expr, UNITS, param, "$", show_state(state));
 
 	} END_FOR_EACH_PTR(arg);
 
@@ -514,7 +516,7 @@ static void process_states(void)
 		if (state == start_state)
 			continue;
 		sql_insert_cache(return_implies, "0x%llx, '%s', 0, %d, %d, %d, '%s', '%s'",
-				 get_base_file_id(), get_function(), fn_static(), UNITS, param, "$", state->name);
+				 get_base_file_id(), get_function(), fn_static(), UNITS, param, "$", show_state(state));
 	} END_FOR_EACH_PTR(arg);
 }
 
@@ -525,7 +527,7 @@ char *get_unit_str(struct expression *expr)
 	state = get_units(expr);
 	if (!state)
 		return NULL;
-	return (char *)state->name;
+	return (char *)show_state(state);
 }
 
 void register_units(int id)
@@ -31,6 +31,10 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "lib.h"
 #include "allocate.h"
@@ -1018,6 +1022,346 @@ struct token * tokenize_buffer(void *buffer, unsigned long size, struct token **
 	return begin;
 }
 
+/*
+ * -ftoken-cache=<dir> saves the tokens of each file the first time it is
+ * tokenized and loads them from <dir> after that.  The cache file is named
+ * after the device, inode, size and mtime of the source file and those are
+ * checked again when it is loaded.  Only the raw tokens are saved; the
+ * preprocessor still runs every time so the cache doesn't depend on which
+ * macros are defined.  Files which cause a warning are not cached, so that
+ * the warning is printed again next time.
+ *
+ * The file is the header, then the identifiers, then the tokens, then the
+ * data for the identifiers, numbers and strings.
+ */
+#define TOKEN_CACHE_MAGIC "sptok01"
+
+struct token_cache_header {
+	char magic[8];
+	uint64_t dev, ino, size, mtime, mtime_nsec;
+	uint32_t tabstop;
+	uint32_t nr_idents, nr_tokens, data_size;
+	uint32_t end_line, end_pos, end_flags;
+};
+
+struct cached_ident {
+	uint32_t offset, len;
+};
+
+#define CACHED_NEWLINE		1
+#define CACHED_WHITESPACE	2
+
+struct cached_token {
+	uint8_t type, flags;
+	uint16_t pos;
+	uint32_t line;
+	uint32_t value;
+};
+
+struct cache_buf {
+	char *data;
+	size_t len, alloc;
+};
+
+static uint32_t cache_buf_add(struct cache_buf *buf, const void *data, size_t len)
+{
+	uint32_t offset = buf->len;
+
+	if (buf->len + len > buf->alloc) {
+		buf->alloc = (buf->len + len) * 2 + 4096;
+		buf->data = realloc(buf->data, buf->alloc);
+		if (!buf->data)
+			die("out of memory");
+	}
+	memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+	return offset;
+}
+
+static char *token_cache_name(struct token_cache_header *hdr)
+{
+	static char buf[PATH_MAX];
+	const unsigned char *p = (const unsigned char *)hdr;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	size_t i;
+
+	/* FNV-1a of the magic and the stat() fields */
+	for (i = 0; i < offsetof(struct token_cache_header, nr_idents); i++)
+		hash = (hash ^ p[i]) * 0x100000001b3ULL;
+	snprintf(buf, sizeof(buf), "%s/%016llx.tok", ftoken_cache,
+		 (unsigned long long)hash);
+	return buf;
+}
+
+static int cached_flags(struct position pos)
+{
+	return (pos.newline ? CACHED_NEWLINE : 0) |
+	       (pos.whitespace ? CACHED_WHITESPACE : 0);
+}
+
+static uint32_t cache_ident(struct cache_buf *idents, struct cache_buf *data,
+			    struct ident **table, uint32_t *table_idx, size_t mask,
+			    struct ident *ident)
+{
+	struct cached_ident ci;
+	size_t slot = ((uintptr_t)ident >> 4) & mask;
+
+	while (table[slot]) {
+		if (table[slot] == ident)
+			return table_idx[slot];
+		slot = (slot + 1) & mask;
+	}
+	ci.offset = cache_buf_add(data, ident->name, ident->len);
+	ci.len = ident->len;
+	table[slot] = ident;
+	table_idx[slot] = idents->len / sizeof(ci);
+	cache_buf_add(idents, &ci, sizeof(ci));
+	return table_idx[slot];
+}
+
+static void save_token_cache(struct token_cache_header *hdr, struct token *begin, struct token *end)
+{
+	struct cache_buf idents = {}, tokens = {}, data = {};
+	struct ident **table = NULL;
+	uint32_t *table_idx = NULL;
+	struct cached_token ct;
+	struct token *token;
+	char tmp[PATH_MAX];
+	size_t nr = 0, mask;
+	uint32_t len;
+	int type;
+	FILE *fp;
+
+	for (token = begin->next; token != end; token = token->next)
+		nr++;
+	for (mask = 1023; mask < nr * 2; mask = mask * 2 + 1)
+		;
+	table = calloc(mask + 1, sizeof(*table));
+	table_idx = malloc((mask + 1) * sizeof(*table_idx));
+	if (!table || !table_idx)
+		goto out;
+
+	for (token = begin->next; token != end; token = token->next) {
+		type = token_type(token);
+		memset(&ct, 0, sizeof(ct));
+		ct.type = type;
+		ct.flags = cached_flags(token->pos);
+		ct.pos = token->pos.pos;
+		ct.line = token->pos.line;
+
+		switch (type) {
+		case TOKEN_IDENT:
+			ct.value = cache_ident(&idents, &data, table, table_idx, mask, token->ident);
+			break;
+		case TOKEN_NUMBER:
+			ct.value = cache_buf_add(&data, token->number, strlen(token->number) + 1);
+			break;
+		case TOKEN_CHAR:
+		case TOKEN_WIDE_CHAR:
+		case TOKEN_STRING:
+		case TOKEN_WIDE_STRING:
+			len = token->string->length;
+			ct.value = cache_buf_add(&data, &len, sizeof(len));
+			cache_buf_add(&data, token->string->data, len);
+			break;
+		case TOKEN_CHAR_EMBEDDED_0 ... TOKEN_CHAR_EMBEDDED_3:
+		case TOKEN_WIDE_CHAR_EMBEDDED_0 ... TOKEN_WIDE_CHAR_EMBEDDED_3:
+			memcpy(&ct.value, token->embedded, sizeof(ct.value));
+			break;
+		case TOKEN_SPECIAL:
+			ct.value = token->special;
+			break;
+		default:
+			goto out;
+		}
+		cache_buf_add(&tokens, &ct, sizeof(ct));
+	}
+
+	hdr->nr_idents = idents.len / sizeof(struct cached_ident);
+	hdr->nr_tokens = nr;
+	hdr->data_size = data.len;
+	hdr->end_line = end->pos.line;
+	hdr->end_pos = end->pos.pos;
+	hdr->end_flags = cached_flags(end->pos);
+
+	mkdir(ftoken_cache, 0777);
+	snprintf(tmp, sizeof(tmp), "%s.%d", token_cache_name(hdr), getpid());
+	fp = fopen(tmp, "w");
+	if (!fp)
+		goto out;
+	if (fwrite(hdr, sizeof(*hdr), 1, fp) != 1 ||
+	    fwrite(idents.data, 1, idents.len, fp) != idents.len ||
+	    fwrite(tokens.data, 1, tokens.len, fp) != tokens.len ||
+	    fwrite(data.data, 1, data.len, fp) != data.len) {
+		fclose(fp);
+		unlink(tmp);
+		goto out;
+	}
+	if (fclose(fp) || rename(tmp, token_cache_name(hdr)))
+		unlink(tmp);
+out:
+	free(table);
+	free(table_idx);
+	free(idents.data);
+	free(tokens.data);
+	free(data.data);
+}
+
+static void set_cached_pos(struct token *token, int idx, uint32_t line, uint32_t pos, int flags)
+{
+	token->pos.stream = idx;
+	token->pos.line = line;
+	token->pos.pos = pos;
+	token->pos.newline = !!(flags & CACHED_NEWLINE);
+	token->pos.whitespace = !!(flags & CACHED_WHITESPACE);
+	token->pos.noexpand = 0;
+}
+
+static struct token *load_token_cache(struct token_cache_header *want, stream_t *stream,
+				      int idx, struct token **endp)
+{
+	struct token_cache_header *hdr;
+	const struct cached_ident *ci;
+	const struct cached_token *ct;
+	struct ident **idents = NULL;
+	struct token *begin = NULL, *token;
+	struct string *string;
+	const char *data;
+	struct stat st;
+	void *map;
+	uint32_t i, len;
+	int fd;
+
+	fd = open(token_cache_name(want), O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) || st.st_size < sizeof(*hdr)) {
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	hdr = map;
+	if (memcmp(hdr, want, offsetof(struct token_cache_header, nr_idents)) != 0 ||
+	    st.st_size != sizeof(*hdr) +
+			  (uint64_t)hdr->nr_idents * sizeof(*ci) +
+			  (uint64_t)hdr->nr_tokens * sizeof(*ct) +
+			  hdr->data_size)
+		goto out;
+	ci = (const void *)(hdr + 1);
+	ct = (const void *)(ci + hdr->nr_idents);
+	data = (const void *)(ct + hdr->nr_tokens);
+
+	idents = malloc(hdr->nr_idents * sizeof(*idents) + 1);
+	if (!idents)
+		goto out;
+	for (i = 0; i < hdr->nr_idents; i++) {
+		if (!ci[i].len || ci[i].len > 255 ||
+		    ci[i].offset + (uint64_t)ci[i].len > hdr->data_size)
+			goto out;
+		idents[i] = create_hashed_ident(data + ci[i].offset, ci[i].len,
+						hash_name(data + ci[i].offset, ci[i].len));
+	}
+
+	begin = setup_stream(stream, idx, -1, NULL, 0);
+	for (i = 0; i < hdr->nr_tokens; i++, ct++) {
+		token = __alloc_token(0);
+		set_cached_pos(token, idx, ct->line, ct->pos, ct->flags);
+		token_type(token) = ct->type;
+
+		switch (ct->type) {
+		case TOKEN_IDENT:
+			if (ct->value >= hdr->nr_idents)
+				goto bad;
+			token->ident = idents[ct->value];
+			break;
+		case TOKEN_NUMBER:
+			if (ct->value >= hdr->data_size ||
+			    !memchr(data + ct->value, '\0', hdr->data_size - ct->value))
+				goto bad;
+			token->number = xstrdup(data + ct->value);
+			break;
+		case TOKEN_CHAR:
+		case TOKEN_WIDE_CHAR:
+		case TOKEN_STRING:
+		case TOKEN_WIDE_STRING:
+			if (ct->value + (uint64_t)sizeof(len) > hdr->data_size)
+				goto bad;
+			memcpy(&len, data + ct->value, sizeof(len));
+			if (ct->value + (uint64_t)sizeof(len) + len > hdr->data_size)
+				goto bad;
+			string = __alloc_string(len);
+			memcpy(string->data, data + ct->value + sizeof(len), len);
+			string->length = len;
+			token->string = string;
+			break;
+		case TOKEN_CHAR_EMBEDDED_0 ... TOKEN_CHAR_EMBEDDED_3:
+		case TOKEN_WIDE_CHAR_EMBEDDED_0 ... TOKEN_WIDE_CHAR_EMBEDDED_3:
+			memcpy(token->embedded, &ct->value, sizeof(ct->value));
+			break;
+		case TOKEN_SPECIAL:
+			token->special = ct->value;
+			break;
+		default:
+			goto bad;
+		}
+		stream->token = token;
+		add_token(stream);
+	}
+
+	stream->line = hdr->end_line;
+	stream->pos = hdr->end_pos;
+	stream->newline = !!(hdr->end_flags & CACHED_NEWLINE);
+	stream->whitespace = !!(hdr->end_flags & CACHED_WHITESPACE);
+	*endp = mark_eof(stream);
+	goto out;
+bad:
+	begin = NULL;
+out:
+	free(idents);
+	munmap(map, st.st_size);
+	return begin;
+}
+
+static struct token *tokenize_cached(stream_t *stream, int idx, int fd,
+				     unsigned char *buffer, struct token **endp)
+{
+	struct token_cache_header hdr;
+	struct token *begin;
+	unsigned int diagnostics;
+	struct stat st;
+
+	memset(&hdr, 0, sizeof(hdr));
+	if (fd < 0 || fstat(fd, &st) || !S_ISREG(st.st_mode))
+		goto no_cache;
+	memcpy(hdr.magic, TOKEN_CACHE_MAGIC, sizeof(hdr.magic));
+	hdr.dev = st.st_dev;
+	hdr.ino = st.st_ino;
+	hdr.size = st.st_size;
+	hdr.mtime = st.st_mtim.tv_sec;
+	hdr.mtime_nsec = st.st_mtim.tv_nsec;
+	hdr.tabstop = tabstop;
+
+	begin = load_token_cache(&hdr, stream, idx, endp);
+	if (begin)
+		return begin;
+
+	diagnostics = nr_diagnostics;
+	begin = setup_stream(stream, idx, fd, buffer, 0);
+	*endp = tokenize_stream(stream);
+	if (nr_diagnostics == diagnostics)
+		save_token_cache(&hdr, begin, *endp);
+	return begin;
+
+no_cache:
+	begin = setup_stream(stream, idx, fd, buffer, 0);
+	*endp = tokenize_stream(stream);
+	return begin;
+}
+
 struct token * tokenize(const struct position *pos, const char *name, int fd, struct token *endtoken, const char **next_path)
 {
 	struct token *begin, *end;
@@ -1031,8 +1375,12 @@ struct token * tokenize(const struct position *pos, const char *name, int fd, st
 		return endtoken;
 	}
 
-	begin = setup_stream(&stream, idx, fd, buffer, 0);
-	end = tokenize_stream(&stream);
+	if (ftoken_cache && !no_lineno) {
+		begin = tokenize_cached(&stream, idx, fd, buffer, &end);
+	} else {
+		begin = setup_stream(&stream, idx, fd, buffer, 0);
+		end = tokenize_stream(&stream);
+	}
 	if (endtoken)
 		end->next = endtoken;
 	return begin;
@@ -0,0 +1,58 @@
+#include "check_debug.h"
+
+static inline int frob(int y)
+{
+	int x;
+
+	x = 5;
+	if (__builtin_constant_p(x))
+		return 1;
+	return 0;
+}
+
+void test1(int y)
+{
+	int a, b;
+
+	a = frob(y);
+	b = frob(y + 1);
+	__smatch_implied(a);
+	__smatch_implied(b);
+}
+
+void test2(int y)
+{
+	int x;
+
+	x = 5;
+	while (y--) {
+		__smatch_known(__builtin_constant_p(x));
+		x = y;
+	}
+	__smatch_known(__builtin_constant_p(x));
+}
+
+void test3(int y)
+{
+	int x;
+
+	x = y;
+	while (y--) {
+		__smatch_known(__builtin_constant_p(x));
+		x = 5;
+	}
+	__smatch_known(__builtin_constant_p(x));
+}
+/*
+ * check-name: smatch __builtin_constant_p() value cache
+ * check-command: smatch -I.. sm_constant_p_cache.c
+ *
+ * check-output-start
+sm_constant_p_cache.c:19 test1() implied: a = '1'
+sm_constant_p_cache.c:20 test1() implied: b = '1'
+sm_constant_p_cache.c:29 test2() known: '__builtin_constant_p(x)' = '1'.  implied = '1'
+sm_constant_p_cache.c:32 test2() known: '__builtin_constant_p(x)' = '0'.  implied = '0'
+sm_constant_p_cache.c:41 test3() known: '__builtin_constant_p(x)' = '0'.  implied = '0'
+sm_constant_p_cache.c:44 test3() known: '__builtin_constant_p(x)' = '0'.  implied = '0'
+ * check-output-end
+ */
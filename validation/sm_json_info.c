@@ -0,0 +1,13 @@
+int frob(int x)
+{
+	return x;
+}
+/*
+ * check-name: smatch JSON output with --info
+ * check-command: smatch --json --info -I.. sm_json_info.c
+ * check-exit-value: 1
+ *
+ * check-output-start
+--json can't be used with --info
+ * check-output-end
+ */
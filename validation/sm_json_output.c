@@ -0,0 +1,24 @@
+#include "check_debug.h"
+
+int a[4];
+
+int frob(int x)
+{
+	if (x > 4)
+		return 0;
+	return a[x];
+}
+
+void print_str(void)
+{
+	__smatch_note("quote \" and \\ and tab\t.");
+}
+/*
+ * check-name: smatch JSON output
+ * check-command: smatch --json -I.. sm_json_output.c
+ *
+ * check-output-start
+{"file":"sm_json_output.c","line":9,"function":"frob","check":"check_index_overflow","type":"error","msg":"buffer overflow 'a' 4 <= 4","fingerprint":"3067e0a1088e56fe"}
+{"file":"sm_json_output.c","line":14,"function":"print_str","check":"check_debug","type":"msg","msg":"quote \" and \\ and tab\u0009.","fingerprint":"952509542caef4d2"}
+ * check-output-end
+ */
@@ -34,9 +34,9 @@ void frob(struct mid *mid)
  *
  * check-output-start
 sm_mtag11.c:23 frob() implied: &mid->bar = '4096-ptr_max'
-sm_mtag11.c:24 frob() implied: &out2 = '1496362378149650432'
-sm_mtag11.c:25 frob() implied: &out2.x = '1496362378149650456'
-sm_mtag11.c:26 frob() implied: &out2.mid.bar = '1496362378149650436'
+sm_mtag11.c:24 frob() implied: &out2 = '4477540332801507328'
+sm_mtag11.c:25 frob() implied: &out2.x = '4477540332801507352'
+sm_mtag11.c:26 frob() implied: &out2.mid.bar = '4477540332801507332'
 sm_mtag11.c:27 frob() implied: &out2.x - &out2.mid.bar = '5'
 sm_mtag11.c:28 frob() implied: &out2.x - &out2.mid.bar = '20'
  * check-output-end
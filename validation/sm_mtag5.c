@@ -28,10 +28,10 @@ int main(void)
  * check-command: smatch -I.. sm_mtag5.c
  *
  * check-output-start
-sm_mtag5.c:17 main() implied: &x = '7475740836921503744'
-sm_mtag5.c:18 main() implied: &aaa = '6045882893841539072'
-sm_mtag5.c:19 main() implied: &aaa.b = '6045882893841539076'
-sm_mtag5.c:20 main() implied: array = '685747191403540480'
-sm_mtag5.c:21 main() implied: &array[1] = '685747191403540484'
+sm_mtag5.c:17 main() implied: &x = '6715977082066309120'
+sm_mtag5.c:18 main() implied: &aaa = '4398488932007899136'
+sm_mtag5.c:19 main() implied: &aaa.b = '4398488932007899140'
+sm_mtag5.c:20 main() implied: array = '6481428413466791936'
+sm_mtag5.c:21 main() implied: &array[1] = '6481428413466791940'
  * check-output-end
  */
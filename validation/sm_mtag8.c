@@ -35,17 +35,17 @@ void func(void)
  * check-command: ./smatch -I.. sm_mtag8.c
  *
  * check-output-start
-sm_mtag8.c:19 func() implied: &frob = '2203940198711365632'
-sm_mtag8.c:20 func() implied: frob = '2203940198711365632'
-sm_mtag8.c:21 func() implied: p = '2203940198711365632'
-sm_mtag8.c:22 func() implied: &p = '736213126887456768'
-sm_mtag8.c:23 func() implied: fn = '2203940198711365632'
-sm_mtag8.c:24 func() implied: &fn = '7495960107394805760'
-sm_mtag8.c:25 func() implied: array = '14964629169045504'
-sm_mtag8.c:26 func() implied: array_p1 = '14964629169045504'
-sm_mtag8.c:27 func() implied: array_p2 = '14964629169045504'
-sm_mtag8.c:28 func() implied: "123" = '8211539974290595840'
-sm_mtag8.c:29 func() implied: &"123" = '8211539974290595840'
-sm_mtag8.c:30 func() implied: str = '8211539974290595840'
+sm_mtag8.c:19 func() implied: &frob = '3077392881877303296'
+sm_mtag8.c:20 func() implied: frob = '3077392881877303296'
+sm_mtag8.c:21 func() implied: p = '3077392881877303296'
+sm_mtag8.c:22 func() implied: &p = '5347003004913397760'
+sm_mtag8.c:23 func() implied: fn = '3077392881877303296'
+sm_mtag8.c:24 func() implied: &fn = '2941410282008252416'
+sm_mtag8.c:25 func() implied: array = '2307473331133276160'
+sm_mtag8.c:26 func() implied: array_p1 = '2307473331133276160'
+sm_mtag8.c:27 func() implied: array_p2 = '2307473331133276160'
+sm_mtag8.c:28 func() implied: "123" = '8080045369778016256'
+sm_mtag8.c:29 func() implied: &"123" = '8080045369778016256'
+sm_mtag8.c:30 func() implied: str = '8080045369778016256'
  * check-output-end
  */
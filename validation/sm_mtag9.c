@@ -29,12 +29,12 @@ void func(int idx)
  * check-command: ./smatch -I.. sm_mtag9.c
  *
  * check-output-start
-sm_mtag9.c:18 func() implied: array = '3848759869566418944'
-sm_mtag9.c:19 func() implied: &array[1] = '3848759869566418948'
+sm_mtag9.c:18 func() implied: array = '8795161068691984384'
+sm_mtag9.c:19 func() implied: &array[1] = '8795161068691984388'
 sm_mtag9.c:20 func() implied: &array[idx] = '4096-ptr_max'
 sm_mtag9.c:21 func() implied: &array[1] - &array[0] = '4'
 sm_mtag9.c:22 func() implied: &array[idx] - &array[0] = ''
-sm_mtag9.c:23 func() implied: array_p1 = '3848759869566418944'
-sm_mtag9.c:24 func() implied: array_p2 = '3848759869566418944'
+sm_mtag9.c:23 func() implied: array_p1 = '8795161068691984384'
+sm_mtag9.c:24 func() implied: array_p2 = '8795161068691984384'
  * check-output-end
  */